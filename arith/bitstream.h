@@ -8,13 +8,12 @@
 
 #pragma once
 
-#include <istream>
-#include <ostream>
+#include "bytestream.h"
 
 namespace arith {
 
 struct bitistream {
-	std::istream &is;
+	byteistream is;
 	int idx;
 	unsigned char buf;
 
@@ -32,7 +31,7 @@ struct bitistream {
 	}
 };
 struct bitostream {
-	std::ostream &os;
+	byteostream os;
 	int idx;
 	unsigned char buf;
 
@@ -46,19 +45,25 @@ struct bitostream {
 
 	void flush()
 	{
-		if (idx == 0) return; // buffer already empty
-		os << buf;
-		buf = 0; idx = 0; // clear and reset
+		if (idx != 0) put_byte(); // pad the last byte
+		os.flush();
 	}
 
 	bitostream &operator<<(unsigned char bit)
 	{
 		buf |= bit << (7 - idx);
 		if (++idx == 8) {
-			flush();
+			put_byte();
 		}
 		return *this;
 	}
+
+private:
+	void put_byte()
+	{
+		os.put(buf);
+		buf = 0; idx = 0; // clear and reset
+	}
 };
 
 }
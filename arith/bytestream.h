@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Block-buffered byte source and sink for the entropy coders.
+ * The coders work on raw pointers into a buffer, which is refilled or flushed in large chunks.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <istream>
+#include <ostream>
+
+namespace arith {
+
+static const std::size_t BUFSIZE = 1 << 16;
+
+struct byteistream {
+	std::istream &is;
+	std::unique_ptr<unsigned char[]> buf;
+	const unsigned char *cur, *end;
+
+	byteistream(std::istream &_is) : is(_is), buf(new unsigned char[BUFSIZE]), cur(buf.get()), end(buf.get())
+	{}
+
+	~byteistream()
+	{
+		// hand unused bytes back, so the stream is positioned right behind the consumed data
+		if (end != cur) {
+			is.clear();
+			is.seekg(cur - end, std::ios::cur);
+		}
+	}
+
+	byteistream(const byteistream&) = delete;
+	byteistream &operator=(const byteistream&) = delete;
+
+	unsigned char get()
+	{
+		if (cur == end && !refill()) return 0xff; // behaves like the EOF of istream::get
+		return *cur++;
+	}
+
+	void read(void *dst, std::size_t n)
+	{
+		unsigned char *d = (unsigned char*)dst;
+		while (n > 0) {
+			if (cur == end && !refill()) {
+				std::memset(d, 0xff, n);
+				return;
+			}
+			std::size_t m = std::min<std::size_t>(n, end - cur);
+			std::memcpy(d, cur, m);
+			cur += m; d += m; n -= m;
+		}
+	}
+
+private:
+	bool refill()
+	{
+		is.read((char*)buf.get(), BUFSIZE);
+		cur = buf.get();
+		end = cur + is.gcount();
+		return cur != end;
+	}
+};
+
+struct byteostream {
+	std::ostream &os;
+	std::unique_ptr<unsigned char[]> buf;
+	unsigned char *cur, *end;
+
+	byteostream(std::ostream &_os) : os(_os), buf(new unsigned char[BUFSIZE]), cur(buf.get()), end(buf.get() + BUFSIZE)
+	{}
+
+	~byteostream()
+	{
+		flush();
+	}
+
+	byteostream(const byteostream&) = delete;
+	byteostream &operator=(const byteostream&) = delete;
+
+	void put(unsigned char c)
+	{
+		if (cur == end) flush();
+		*cur++ = c;
+	}
+
+	void write(const void *src, std::size_t n)
+	{
+		const unsigned char *s = (const unsigned char*)src;
+		while (n > 0) {
+			if (cur == end) flush();
+			std::size_t m = std::min<std::size_t>(n, end - cur);
+			std::memcpy(cur, s, m);
+			cur += m; s += m; n -= m;
+		}
+	}
+
+	void flush()
+	{
+		os.write((const char*)buf.get(), cur - buf.get());
+		cur = buf.get();
+	}
+};
+
+}
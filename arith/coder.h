@@ -31,6 +31,7 @@ struct Coder {
 	static const int b = sizeof(TF) * 8;
 	static const TF HALF = TF(1) << (b - 1);
 	static const TF QUARTER = TF(1) << (b - 2);
+	static const int FREQ_BITS = b - 2; // largest total that still keeps R / t >= 1
 };
 
 template <typename TF = uint64_t, typename TBO = uint64_t>
@@ -68,7 +69,25 @@ struct Encoder : Coder<TF> {
 
 	void operator()(TF l, TF h, TF t)
 	{
-		TF r = R / t;
+		update(R / t, l, h, t);
+	}
+	// Same as operator()(l, h, 2^bits) without a division
+	void pow2(TF l, TF h, int bits)
+	{
+		update(R >> bits, l, h, TF(1) << bits);
+	}
+	template <typename S>
+	void operator()(S &freq, typename S::SymType s)
+	{
+		TF l, h;
+		freq.range(s, l, h);
+		if (S::TOTAL_BITS) pow2(l, h, S::TOTAL_BITS);
+		else (*this)(l, h, freq.total());
+	}
+
+private:
+	void update(TF r, TF l, TF h, TF t)
+	{
 		L = L + r * l;
 		if (h < t)
 			R = r * (h - l);
@@ -89,15 +108,6 @@ struct Encoder : Coder<TF> {
 			R *= 2;
 		}
 	}
-	template <typename S>
-	void operator()(S &freq, typename S::SymType s)
-	{
-		TF l, h, t = freq.total();
-		freq.range(s, l, h);
-		(*this)(l, h, t);
-	}
-
-private:
 	void write_one_bit(unsigned char bit)
 	{
 		os << bit;
@@ -136,7 +146,16 @@ struct Decoder : Coder<TF> {
 		r = R / t;
 		return std::min(t - 1, D / r);
 	}
+	TF decode_target_pow2(int bits)
+	{
+		r = R >> bits;
+		return std::min((TF(1) << bits) - 1, D / r);
+	}
 
+	void pow2(TF l, TF h, int bits)
+	{
+		(*this)(l, h, TF(1) << bits);
+	}
 	void operator()(TF l, TF h, TF t)
 	{
 		// r already set by decode_target
@@ -154,9 +173,14 @@ struct Decoder : Coder<TF> {
 	template <typename S>
 	typename S::SymType operator()(S &freq)
 	{
-		TF l, h, t = freq.total();
-		TF target = decode_target(t);
-		typename S::SymType s = freq.symbol(target, l, h);
+		TF l, h;
+		if (S::TOTAL_BITS) {
+			typename S::SymType s = freq.symbol(decode_target_pow2(S::TOTAL_BITS), l, h);
+			pow2(l, h, S::TOTAL_BITS);
+			return s;
+		}
+		TF t = freq.total();
+		typename S::SymType s = freq.symbol(decode_target(t), l, h);
 		(*this)(l, h, t);
 		return s;
 	}
@@ -8,22 +8,43 @@
 
 #pragma once
 
+#include <istream>
+#include <ostream>
+
 #include "coder.h"
 
 namespace arith {
 
-template <typename TF = uint64_t>
+// Adaptive statistics modules transmit nothing, static ones overload these (see stat_static.h)
+template <typename S>
+void save_table(std::ostream &os, const S &stat)
+{}
+template <typename S>
+void load_table(std::istream &is, S &stat)
+{}
+
+// E and D may be any coder pair providing operator()(l, h, t) and decode_target (e.g. range.h)
+template <typename E = Encoder<>, typename D = Decoder<>>
 struct Model {
-	virtual void enc(Encoder<TF> &coder, const unsigned char *s, int n) = 0;
-	virtual void dec(Decoder<TF> &coder, unsigned char *s, int n) = 0;
+	virtual ~Model()
+	{}
+
+	virtual void enc(E &coder, const unsigned char *s, int n) = 0;
+	virtual void dec(D &coder, unsigned char *s, int n) = 0;
+
+	// Tables of static models, which are transmitted ahead of the coded data
+	virtual void save(std::ostream &os) const
+	{}
+	virtual void load(std::istream &is)
+	{}
 
 	template <typename T>
-	void encode(Encoder<TF> &coder, const T &s)
+	void encode(E &coder, const T &s)
 	{
 		enc(coder, (const unsigned char*)&s, sizeof(T));
 	}
 	template <typename T>
-	T decode(Decoder<TF> &coder)
+	T decode(D &coder)
 	{
 		T s;
 		dec(coder, (unsigned char*)&s, sizeof(T));
@@ -31,8 +52,10 @@ struct Model {
 	}
 };
 
-template <typename T, typename S, typename TF = uint64_t>
-struct ModelMult : Model<TF> {
+template <typename T, typename S, typename E = Encoder<>, typename D = Decoder<>>
+struct ModelMult : Model<E, D> {
+	typedef T ValueType;
+
 	S stats[sizeof(T)];
 
 	ModelMult(bool init = true)
@@ -54,7 +77,7 @@ struct ModelMult : Model<TF> {
 		}
 	}
 
-	void enc(Encoder<TF> &coder, const unsigned char *s, int n)
+	void enc(E &coder, const unsigned char *s, int n)
 	{
 #ifdef HAVE_ASSERT
 		assert_eq(sizeof(T), n);
@@ -65,7 +88,7 @@ struct ModelMult : Model<TF> {
 		}
 	}
 
-	void dec(Decoder<TF> &coder, unsigned char *s, int n)
+	void dec(D &coder, unsigned char *s, int n)
 	{
 #ifdef HAVE_ASSERT
 		assert_eq(sizeof(T), n);
@@ -75,6 +98,85 @@ struct ModelMult : Model<TF> {
 			this->stats[i].inc(s[i]);
 		}
 	}
+
+	void save(std::ostream &os) const
+	{
+		for (int i = 0; i < sizeof(T); ++i) {
+			save_table(os, stats[i]);
+		}
+	}
+	void load(std::istream &is)
+	{
+		for (int i = 0; i < sizeof(T); ++i) {
+			load_table(is, stats[i]);
+		}
+	}
+};
+
+// Binarizes every byte through a context tree (one node per prefix of the byte) of adaptive bit probabilities
+template <typename T, typename E = Encoder<>, typename D = Decoder<>>
+struct ModelBinary : Model<E, D> {
+	typedef T ValueType;
+
+	static const int BITS = 12; // probability precision
+	static const int SPEED = 5; // adaption rate, larger is slower
+	static const uint32_t ONE = 1 << BITS;
+
+	uint16_t p[sizeof(T)][256]; // probability of a zero bit, node 0 is unused
+
+	ModelBinary()
+	{
+		for (int i = 0; i < sizeof(T); ++i) {
+			for (int j = 0; j < 256; ++j) {
+				p[i][j] = ONE / 2;
+			}
+		}
+	}
+
+	void enc(E &coder, const unsigned char *s, int n)
+	{
+#ifdef HAVE_ASSERT
+		assert_eq(sizeof(T), n);
+#endif
+		for (int i = 0; i < sizeof(T); ++i) {
+			uint16_t *pi = p[i];
+			unsigned ctx = 1;
+			for (int k = 7; k >= 0; --k) {
+				unsigned bit = (s[i] >> k) & 1;
+				if (bit) coder.pow2(pi[ctx], ONE, BITS);
+				else coder.pow2(0, pi[ctx], BITS);
+				update(pi[ctx], bit);
+				ctx = 2 * ctx + bit;
+			}
+		}
+	}
+
+	void dec(D &coder, unsigned char *s, int n)
+	{
+#ifdef HAVE_ASSERT
+		assert_eq(sizeof(T), n);
+#endif
+		for (int i = 0; i < sizeof(T); ++i) {
+			uint16_t *pi = p[i];
+			unsigned ctx = 1;
+			for (int k = 7; k >= 0; --k) {
+				unsigned bit = coder.decode_target_pow2(BITS) >= pi[ctx];
+				if (bit) coder.pow2(pi[ctx], ONE, BITS);
+				else coder.pow2(0, pi[ctx], BITS);
+				update(pi[ctx], bit);
+				ctx = 2 * ctx + bit;
+			}
+			s[i] = ctx;
+		}
+	}
+
+private:
+	static void update(uint16_t &p, unsigned bit)
+	{
+		// p never reaches 0 or ONE, so both bits keep a non-empty range
+		if (bit) p -= p >> SPEED;
+		else p += (ONE - p) >> SPEED;
+	}
 };
 
 }
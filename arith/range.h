@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Implementation of a byte-oriented Range Coder with carry propagation.
+ *
+ * Related publications:
+ * Martin, G. Nigel N. "Range encoding: an algorithm for removing redundancy from a digitised message." Video and Data Recording Conference, 1979.
+ * Subbotin, Dmitry. "Carryless rangecoder." 1999.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include "bytestream.h"
+
+namespace arith {
+
+struct RangeCoder {
+	typedef uint64_t FreqType;
+
+	static const int WINDOW = 56; // width of the coding window; bit 56 of L receives the carry
+	static const int SHIFT = WINDOW - 8;
+	static const FreqType TOP = FreqType(1) << WINDOW;
+	static const FreqType BOT = FreqType(1) << SHIFT; // renormalize as soon as R drops below
+	static const int FREQ_BITS = SHIFT - 8; // keeps R / t >= 2^8
+};
+
+struct RangeEncoder : RangeCoder {
+	FreqType L, R; // L = low, R = range
+	uint64_t pending; // cache byte plus number of 0xff bytes waiting for a carry
+	unsigned char cache;
+	byteostream os;
+	bool flushed;
+
+	RangeEncoder(std::ostream &_os) : os(_os), L(0), R(TOP - 1), pending(1), cache(0), flushed(false)
+	{}
+
+	~RangeEncoder()
+	{
+		flush();
+	}
+
+	RangeEncoder(const RangeEncoder&) = delete;
+	RangeEncoder &operator=(const RangeEncoder&) = delete;
+
+	void flush()
+	{
+		if (flushed) return;
+		flushed = true;
+
+		for (int i = 0; i < WINDOW / 8 + 1; ++i) {
+			shift_low();
+		}
+		os.flush();
+	}
+
+	void operator()(FreqType l, FreqType h, FreqType t)
+	{
+		update(R / t, l, h, t);
+	}
+	// Same as operator()(l, h, 2^bits) without a division
+	void pow2(FreqType l, FreqType h, int bits)
+	{
+		update(R >> bits, l, h, FreqType(1) << bits);
+	}
+	template <typename S>
+	void operator()(S &freq, typename S::SymType s)
+	{
+		FreqType l, h;
+		freq.range(s, l, h);
+		if (S::TOTAL_BITS) pow2(l, h, S::TOTAL_BITS);
+		else (*this)(l, h, freq.total());
+	}
+
+private:
+	void update(FreqType r, FreqType l, FreqType h, FreqType t)
+	{
+		L = L + r * l;
+		if (h < t)
+			R = r * (h - l);
+		else
+			R = R - r * l;
+
+		while (R < BOT) {
+			R <<= 8;
+			shift_low();
+		}
+	}
+
+	void shift_low()
+	{
+		// the top byte is only final if it is not 0xff or a carry has arrived
+		if (L < (FreqType(0xff) << SHIFT) || L >= TOP) {
+			unsigned char carry = L >> WINDOW;
+			unsigned char c = cache;
+			do {
+				os.put(c + carry);
+				c = 0xff;
+			} while (--pending != 0);
+			cache = L >> SHIFT;
+		}
+		++pending;
+		L = (L & (BOT - 1)) << 8;
+	}
+};
+
+struct RangeDecoder : RangeCoder {
+	FreqType R, D, r; // R = range, D = code value relative to low
+	byteistream is;
+
+	RangeDecoder(std::istream &_is) : is(_is), R(TOP - 1), D(0)
+	{
+		for (int i = 0; i < WINDOW / 8 + 1; ++i) {
+			D = (D << 8) | read_byte();
+		}
+	}
+
+	RangeDecoder(const RangeDecoder&) = delete;
+	RangeDecoder &operator=(const RangeDecoder&) = delete;
+
+	FreqType decode_target(FreqType t)
+	{
+		r = R / t;
+		return std::min(t - 1, D / r);
+	}
+	FreqType decode_target_pow2(int bits)
+	{
+		r = R >> bits;
+		return std::min((FreqType(1) << bits) - 1, D / r);
+	}
+
+	void pow2(FreqType l, FreqType h, int bits)
+	{
+		(*this)(l, h, FreqType(1) << bits);
+	}
+	void operator()(FreqType l, FreqType h, FreqType t)
+	{
+		// r already set by decode_target
+		D = D - r * l;
+		if (h < t)
+			R = r * (h - l);
+		else
+			R = R - r * l;
+
+		while (R < BOT) {
+			R <<= 8;
+			D = (D << 8) | read_byte();
+		}
+	}
+	template <typename S>
+	typename S::SymType operator()(S &freq)
+	{
+		FreqType l, h;
+		if (S::TOTAL_BITS) {
+			typename S::SymType s = freq.symbol(decode_target_pow2(S::TOTAL_BITS), l, h);
+			pow2(l, h, S::TOTAL_BITS);
+			return s;
+		}
+		FreqType t = freq.total();
+		typename S::SymType s = freq.symbol(decode_target(t), l, h);
+		(*this)(l, h, t);
+		return s;
+	}
+
+private:
+	unsigned char read_byte()
+	{
+		return is.get();
+	}
+};
+
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Implementation of an interleaved range Asymmetric Numeral Systems (rANS) coder.
+ *
+ * Related publications:
+ * Duda, Jarek. "Asymmetric numeral systems: entropy coding combining speed of Huffman coding with compression rate of arithmetic coding." arXiv preprint arXiv:1311.2540 (2013).
+ * Giesen, Fabian. "Interleaved entropy coders." arXiv preprint arXiv:1402.3392 (2014).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "bytestream.h"
+
+namespace arith {
+
+// Symbols are distributed round-robin over N independent states and coded in blocks of K symbols.
+// Each block starts with the N final encoder states followed by the 32 bit words of all lanes.
+template <int N = 4, int K = 1 << 16>
+struct RansCoder {
+	typedef uint64_t FreqType;
+
+	static const int SCALE = 31;
+	static const uint64_t M = uint64_t(1) << SCALE; // all (l, h, t) triples are mapped onto [0, M)
+	static const uint64_t L = uint64_t(1) << 31; // lower bound of the normalized state interval
+	static const int FREQ_BITS = SCALE; // t <= M is required for an exact mapping
+
+	// Maps the cumulative frequency c of a total of t onto [0, M]; rounding up keeps every non-empty range non-empty
+	static uint64_t scale(FreqType c, FreqType t)
+	{
+		return ((c << SCALE) + t - 1) / t;
+	}
+};
+
+template <int N = 4, int K = 1 << 16>
+struct RansEncoder : RansCoder<N, K> {
+	typedef RansCoder<N, K> Base;
+	using typename Base::FreqType;
+	using Base::SCALE;
+	using Base::L;
+
+	struct Sym {
+		uint32_t start, freq;
+	};
+
+	std::vector<Sym> syms; // encoding has to run backwards, so the current block is buffered
+	std::vector<uint32_t> words;
+	byteostream os;
+	bool flushed;
+
+	RansEncoder(std::ostream &_os) : os(_os), flushed(false)
+	{
+		syms.reserve(K);
+	}
+
+	~RansEncoder()
+	{
+		flush();
+	}
+
+	RansEncoder(const RansEncoder&) = delete;
+	RansEncoder &operator=(const RansEncoder&) = delete;
+
+	void flush()
+	{
+		if (flushed) return;
+		flushed = true;
+
+		encode_block();
+		os.flush();
+	}
+
+	void operator()(FreqType l, FreqType h, FreqType t)
+	{
+		uint64_t start = Base::scale(l, t);
+		push(start, Base::scale(h, t) - start);
+	}
+	// Same as operator()(l, h, 2^bits) without divisions
+	void pow2(FreqType l, FreqType h, int bits)
+	{
+		push(l << (SCALE - bits), (h - l) << (SCALE - bits));
+	}
+	template <typename S>
+	void operator()(S &freq, typename S::SymType s)
+	{
+		FreqType l, h;
+		freq.range(s, l, h);
+		if (S::TOTAL_BITS) pow2(l, h, S::TOTAL_BITS);
+		else (*this)(l, h, freq.total());
+	}
+
+private:
+	void push(uint64_t start, uint64_t freq)
+	{
+		syms.push_back(Sym{ (uint32_t)start, (uint32_t)freq });
+		if (syms.size() == K) encode_block();
+	}
+	void encode_block()
+	{
+		if (syms.empty()) return;
+
+		uint64_t x[N];
+		for (int j = 0; j < N; ++j) x[j] = L;
+
+		words.clear();
+		for (int i = syms.size() - 1; i >= 0; --i) {
+			uint64_t &xj = x[i % N];
+			uint64_t f = syms[i].freq;
+			// renormalize, such that the state stays in [L, L << 32) after encoding
+			if (xj >= (f << 32)) {
+				words.push_back((uint32_t)xj);
+				xj >>= 32;
+			}
+			xj = ((xj / f) << SCALE) + (xj % f) + syms[i].start;
+		}
+
+		os.write((const char*)x, sizeof(x));
+		for (int i = words.size() - 1; i >= 0; --i) {
+			os.write((const char*)&words[i], 4);
+		}
+		syms.clear();
+	}
+};
+
+template <int N = 4, int K = 1 << 16>
+struct RansDecoder : RansCoder<N, K> {
+	typedef RansCoder<N, K> Base;
+	using typename Base::FreqType;
+	using Base::SCALE;
+	using Base::M;
+	using Base::L;
+
+	uint64_t x[N];
+	uint64_t slot;
+	int i; // position inside the current block
+	byteistream is;
+
+	RansDecoder(std::istream &_is) : is(_is), i(K)
+	{}
+
+	RansDecoder(const RansDecoder&) = delete;
+	RansDecoder &operator=(const RansDecoder&) = delete;
+
+	FreqType decode_target(FreqType t)
+	{
+		return (next_slot() * t) >> SCALE;
+	}
+	FreqType decode_target_pow2(int bits)
+	{
+		return next_slot() >> (SCALE - bits);
+	}
+
+	void operator()(FreqType l, FreqType h, FreqType t)
+	{
+		// slot already set by decode_target
+		uint64_t start = Base::scale(l, t);
+		pop(start, Base::scale(h, t) - start);
+	}
+	void pow2(FreqType l, FreqType h, int bits)
+	{
+		pop(l << (SCALE - bits), (h - l) << (SCALE - bits));
+	}
+	template <typename S>
+	typename S::SymType operator()(S &freq)
+	{
+		FreqType l, h;
+		if (S::TOTAL_BITS) {
+			typename S::SymType s = freq.symbol(decode_target_pow2(S::TOTAL_BITS), l, h);
+			pow2(l, h, S::TOTAL_BITS);
+			return s;
+		}
+		FreqType t = freq.total();
+		typename S::SymType s = freq.symbol(decode_target(t), l, h);
+		(*this)(l, h, t);
+		return s;
+	}
+
+private:
+	uint64_t next_slot()
+	{
+		if (i == K) {
+			is.read((char*)x, sizeof(x));
+			i = 0;
+		}
+		slot = x[i % N] & (M - 1);
+		return slot;
+	}
+	void pop(uint64_t start, uint64_t freq)
+	{
+		uint64_t &xj = x[i % N];
+		xj = freq * (xj >> SCALE) + slot - start;
+		if (xj < L) {
+			uint32_t w;
+			is.read((char*)&w, 4);
+			xj = (xj << 32) | w;
+		}
+		++i;
+	}
+};
+
+}
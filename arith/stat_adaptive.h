@@ -12,32 +12,44 @@
  * Related publications:
  * Fenwick, Peter M. "A New Data Structure for Cumulative Frequency Tables." Software: Practice and Experience 24.3 (1994): 327-336.
  * Fenwick, P. A New Data Structure for Cumulative Probability Tables: an Improved Frequency to Symbol Algorithm. Department of Computer Science, The University of Auckland, New Zealand, 1995.
+ *
+ * Symbols are decoded through a guide table, which maps coarse target ranges to symbols and is rebuilt lazily.
  */
 
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include <stdint.h>
 #include "msb.h"
 
 namespace arith {
 
 // Implementation of a Fenwick Tree
-template <typename TF = uint64_t, typename TS = uint32_t, typename TC = uint32_t>
+template <typename TF = uint64_t, typename TS = uint32_t, typename TC = uint32_t, int FB = sizeof(TF) * 8 - 2>
 struct AdaptiveStatisticsModule {
 	typedef TF FreqType;
 	typedef TS SymType;
 	typedef TC CountType;
 
 	static const int b = sizeof(TF) * 8;
-	static const int f = b - 2;
+	static const int f = FB; // total is kept below 2^f, see the coder's FREQ_BITS
 	static const TF FFULL = TF(1) << f;
+	static const int TOTAL_BITS = 0; // the total is not a fixed power of two
+	static const TC MIN_PERIOD = 16;
 
 	std::vector<TF> F, C;
+	TF tot;
 	TC n;
 	TS mid;
 
-	AdaptiveStatisticsModule(TC _n = 256) : F(_n, 0), C(_n, 0), n(_n), mid(msb(_n))
+	// guide[k] is the symbol of target k << shift at the time of the last rebuild; it has twice the required size,
+	// so it stays valid while the total grows
+	std::vector<TS> guide;
+	int shift;
+	TC period, upd;
+
+	AdaptiveStatisticsModule(TC _n = 256) : F(_n, 0), C(_n, 0), tot(0), n(_n), mid(msb(_n)), guide(2 * mid, 0), shift(0), period(MIN_PERIOD), upd(MIN_PERIOD)
 	{}
 
 	AdaptiveStatisticsModule(const AdaptiveStatisticsModule&) = delete;
@@ -50,24 +62,24 @@ struct AdaptiveStatisticsModule {
 	}
 	TF total() const
 	{
-		return cumulative(n - 1);
+		return tot;
 	}
 	TS symbol(TF target, TF &l, TF &h)
 	{
-		TS s = 0;
-		TF original = target;
-		if (original >= F[0]) {
-			TS cur_mid = mid;
-			while (cur_mid > 0) {
-				if (s + cur_mid <= n && F[s + cur_mid - 1] <= target) {
-					target -= F[s + cur_mid - 1];
-					s += cur_mid;
-				}
-				cur_mid >>= 1;
-			}
+		if (upd >= period) build_guide();
+
+		TS s = guide[std::min<TF>(target >> shift, guide.size() - 1)];
+		h = cumulative(s);
+		l = h - C[s];
+		// the counts changed since the last rebuild, so the guide is only a starting point for a short search
+		while (target < l) {
+			h = l;
+			l -= C[--s];
+		}
+		while (target >= h) {
+			l = h;
+			h += C[++s];
 		}
-		l = original - target;
-		h = l + C[s];
 		return s;
 	}
 	void init(TS s, TF incr = 1)
@@ -90,9 +102,13 @@ struct AdaptiveStatisticsModule {
 	}
 	void halve()
 	{
+		tot = 0;
 		for (TS i = 0; i < n; ++i) {
-			inc_impl(i, -(frequency(i) >> 1));
+			C[i] -= C[i] >> 1;
+			tot += C[i];
 		}
+		build();
+		upd = period;
 	}
 	TF cumulative(TS s) const
 	{
@@ -122,6 +138,33 @@ private:
 			i = forward(i);
 		}
 		C[s] += inc;
+		tot += inc;
+		++upd;
+	}
+	// Rebuilds the tree from C in linear time by pushing every node into its parent
+	void build()
+	{
+		for (TS i = 0; i < n; ++i) F[i] = C[i];
+		for (TS i = 1; i <= n; ++i) {
+			TS j = forward(i);
+			if (j <= n) F[j - 1] += F[i - 1];
+		}
+	}
+	void build_guide()
+	{
+		upd = 0;
+		// adapt quickly at first, then amortize the O(n) rebuild over n updates
+		if (period < n) period *= 2;
+
+		shift = 0;
+		while (shift < b - 1 && ((tot - 1) >> shift) >= mid) ++shift;
+		TS s = 0;
+		TF h = C[0];
+		for (TC k = 0; k < guide.size(); ++k) {
+			TF t = TF(k) << shift;
+			while (h <= t && s + 1 < n) h += C[++s];
+			guide[k] = s;
+		}
 	}
 };
 
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Adaptive statistics module with a total that is always 2^TB.
+ * The adaptive counts are renormalized into a table of cumulative frequencies in periodic intervals,
+ * so the coders can replace their divisions by the total with shifts.
+ */
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+namespace arith {
+
+// Scales the n counts C with the sum tot to frequencies F with a sum of 2^TB.
+// Every symbol that occurred keeps a non-zero frequency, the rounding error is corrected afterwards.
+template <typename TC>
+void quantize_pow2(const uint32_t *C, TC n, uint64_t tot, int TB, uint32_t *F)
+{
+	const uint64_t TOTAL = uint64_t(1) << TB;
+	uint64_t scale = (TOTAL << 32) / (tot == 0 ? 1 : tot);
+	int64_t sum = 0;
+	TC largest = 0;
+	for (TC i = 0; i < n; ++i) {
+		uint32_t f = (C[i] * scale) >> 32;
+		if (f == 0 && C[i] != 0) f = 1;
+		F[i] = f;
+		sum += f;
+		if (f > F[largest]) largest = i;
+	}
+	int64_t diff = (int64_t)TOTAL - sum;
+	if (diff >= 0) {
+		F[largest] += diff;
+	} else {
+		for (TC i = 0; i < n && diff < 0; ++i) {
+			int64_t d = std::min<int64_t>(-diff, (int64_t)F[i] - 1);
+			if (d > 0) {
+				F[i] -= d;
+				diff += d;
+			}
+		}
+	}
+}
+
+template <int TB = 16, typename TS = uint32_t, typename TC = uint32_t>
+struct Pow2StatisticsModule {
+	typedef uint64_t FreqType;
+	typedef TS SymType;
+	typedef TC CountType;
+
+	static const int TOTAL_BITS = TB;
+	static const FreqType TOTAL = FreqType(1) << TB;
+	static const FreqType FFULL = FreqType(1) << 24; // limit of the adaptive counts
+	static const TC MIN_PERIOD = 16;
+
+	std::vector<uint32_t> C; // adaptive counts
+	std::vector<uint32_t> H; // normalized cumulative frequencies, H[0] = 0 and H[n] = TOTAL
+	FreqType tot;
+	TC n, period, upd;
+	bool dirty;
+
+	Pow2StatisticsModule(TC _n = 256) : C(_n, 0), H(_n + 1, 0), tot(0), n(_n), period(MIN_PERIOD), upd(0), dirty(true)
+	{}
+
+	Pow2StatisticsModule(const Pow2StatisticsModule&) = delete;
+	Pow2StatisticsModule &operator=(const Pow2StatisticsModule&) = delete;
+
+	void range(TS s, FreqType &l, FreqType &h)
+	{
+		if (dirty) renormalize();
+		l = H[s];
+		h = H[s + 1];
+	}
+	FreqType total() const
+	{
+		return TOTAL;
+	}
+	TS symbol(FreqType target, FreqType &l, FreqType &h)
+	{
+		if (dirty) renormalize();
+		TS s = std::upper_bound(H.begin() + 1, H.end(), (uint32_t)target) - (H.begin() + 1);
+		l = H[s];
+		h = H[s + 1];
+		return s;
+	}
+	void init(TS s, FreqType incr = 1)
+	{
+		C[s] += incr;
+		tot += incr;
+		dirty = true;
+	}
+	void inc(TS s, FreqType inc = 1)
+	{
+		C[s] += inc;
+		tot += inc;
+		if (tot > FFULL) halve();
+		if (++upd >= period) {
+			dirty = true;
+			// adapt quickly at first, then amortize the O(n) renormalization over n symbols
+			if (period < n) period *= 2;
+		}
+	}
+	FreqType frequency(TS s) const
+	{
+		return C[s];
+	}
+	void set(TS s, FreqType f)
+	{
+		tot += f - C[s];
+		C[s] = f;
+		dirty = true;
+	}
+	void halve()
+	{
+		tot = 0;
+		for (TC i = 0; i < n; ++i) {
+			C[i] -= C[i] >> 1;
+			tot += C[i];
+		}
+	}
+
+private:
+	void renormalize()
+	{
+		dirty = false;
+		upd = 0;
+
+		quantize_pow2(C.data(), n, tot, TB, H.data() + 1);
+		for (TC i = 0; i < n; ++i) {
+			H[i + 1] += H[i];
+		}
+	}
+};
+
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Cumulative frequency table for tiny alphabets with a size known at compile time.
+ * All cumulative counts share a single cache line, so search and update are a few vector operations.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace arith {
+
+template <int N, int FB = 30>
+struct SmallStatisticsModule {
+	typedef uint64_t FreqType;
+	typedef uint32_t SymType;
+
+	static_assert(N > 0 && N <= 16, "Alphabet too large for a single cache line");
+	static_assert(FB <= 30, "Counts must stay positive as signed 32 bit integers");
+
+	static const int NP = (N + 3) & ~3; // padded to whole vectors
+	static const uint32_t FFULL = uint32_t(1) << FB;
+	static const int TOTAL_BITS = 0; // the total is not a fixed power of two
+
+	// H[s] = sum of frequencies of all symbols <= s; padding entries always hold the total
+	alignas(64) uint32_t H[NP];
+
+	SmallStatisticsModule()
+	{
+		for (int i = 0; i < NP; ++i) H[i] = 0;
+	}
+
+	SmallStatisticsModule(const SmallStatisticsModule&) = delete;
+	SmallStatisticsModule &operator=(const SmallStatisticsModule&) = delete;
+
+	void range(SymType s, FreqType &l, FreqType &h) const
+	{
+		h = H[s];
+		l = s == 0 ? 0 : H[s - 1];
+	}
+	FreqType total() const
+	{
+		return H[NP - 1];
+	}
+	SymType symbol(FreqType target, FreqType &l, FreqType &h) const
+	{
+		// the symbol is the number of entries <= target
+		SymType s = 0;
+#ifdef __SSE2__
+		__m128i t = _mm_set1_epi32((int32_t)target);
+		for (int i = 0; i < NP; i += 4) {
+			__m128i le = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(H + i)), t);
+			s += 4 - __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(le)));
+		}
+#else
+		for (int i = 0; i < NP; ++i) s += H[i] <= target;
+#endif
+		range(s, l, h);
+		return s;
+	}
+	void init(SymType s, FreqType incr = 1)
+	{
+		inc(s, incr);
+	}
+	void inc(SymType s, FreqType inc = 1)
+	{
+		add(s, inc);
+		if (total() > FFULL) halve();
+	}
+	FreqType frequency(SymType s) const
+	{
+		return H[s] - (s == 0 ? 0 : H[s - 1]);
+	}
+	void set(SymType s, FreqType f)
+	{
+		add(s, (uint32_t)f - (uint32_t)frequency(s));
+	}
+	void halve()
+	{
+		uint32_t h = 0, prev = 0;
+		for (int i = 0; i < N; ++i) {
+			uint32_t f = H[i] - prev;
+			prev = H[i];
+			h += f - (f >> 1);
+			H[i] = h;
+		}
+		for (int i = N; i < NP; ++i) H[i] = h;
+	}
+	FreqType cumulative(SymType s) const
+	{
+		return H[s];
+	}
+
+private:
+	void add(SymType s, uint32_t d)
+	{
+#ifdef __SSE2__
+		__m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+		__m128i first = _mm_set1_epi32((int32_t)s - 1);
+		__m128i vd = _mm_set1_epi32((int32_t)d);
+		for (int i = 0; i < NP; i += 4) {
+			__m128i *p = (__m128i*)(H + i);
+			__m128i mask = _mm_cmpgt_epi32(idx, first);
+			_mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), _mm_and_si128(mask, vd)));
+			idx = _mm_add_epi32(idx, _mm_set1_epi32(4));
+		}
+#else
+		for (int i = s; i < NP; ++i) H[i] += d;
+#endif
+	}
+};
+
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Static statistics modules for two-pass coding.
+ * A first pass drives the models with the NullEncoder/NullDecoder pair and counts all symbols in CountingStatisticsModules.
+ * Their quantized tables are transmitted ahead of the coded data and loaded into StaticStatisticsModules,
+ * which never change, so updates are free and the decoder finds symbols with a direct lookup.
+ */
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "stat_pow2.h"
+
+namespace arith {
+
+// Encoder without output, which only drives the models
+struct NullEncoder {
+	typedef uint64_t FreqType;
+
+	static const int FREQ_BITS = 62;
+
+	void flush()
+	{}
+	void operator()(FreqType l, FreqType h, FreqType t)
+	{}
+	void pow2(FreqType l, FreqType h, int bits)
+	{}
+	template <typename S>
+	void operator()(S &freq, typename S::SymType s)
+	{}
+};
+
+// Counterpart of the NullEncoder, which only completes the model interface
+struct NullDecoder {
+	typedef uint64_t FreqType;
+
+	FreqType decode_target(FreqType t)
+	{
+		return 0;
+	}
+	FreqType decode_target_pow2(int bits)
+	{
+		return 0;
+	}
+	void operator()(FreqType l, FreqType h, FreqType t)
+	{}
+	void pow2(FreqType l, FreqType h, int bits)
+	{}
+	template <typename S>
+	typename S::SymType operator()(S &freq)
+	{
+		return 0;
+	}
+};
+
+template <int TB = 12, typename TS = uint32_t, typename TC = uint32_t>
+struct CountingStatisticsModule {
+	typedef uint64_t FreqType;
+	typedef TS SymType;
+	typedef TC CountType;
+
+	static const int TOTAL_BITS = TB;
+	static const FreqType FFULL = FreqType(1) << 31; // keeps the counts within 32 bits
+
+	std::vector<uint32_t> C;
+	FreqType tot;
+	TC n;
+
+	CountingStatisticsModule(TC _n = 256) : C(_n, 0), tot(0), n(_n)
+	{}
+
+	CountingStatisticsModule(const CountingStatisticsModule&) = delete;
+	CountingStatisticsModule &operator=(const CountingStatisticsModule&) = delete;
+
+	void init(TS s, FreqType incr = 1)
+	{
+		// only coded symbols enter the table
+	}
+	void inc(TS s, FreqType inc = 1)
+	{
+		C[s] += inc;
+		tot += inc;
+		if (tot > FFULL) halve();
+	}
+	void halve()
+	{
+		tot = 0;
+		for (TC i = 0; i < n; ++i) {
+			C[i] -= C[i] >> 1;
+			tot += C[i];
+		}
+	}
+};
+
+template <int TB = 12, typename TS = uint32_t, typename TC = uint32_t>
+struct StaticStatisticsModule {
+	typedef uint64_t FreqType;
+	typedef TS SymType;
+	typedef TC CountType;
+
+	static_assert(TB <= 15, "Frequencies are stored with 16 bits");
+
+	static const int TOTAL_BITS = TB;
+	static const FreqType TOTAL = FreqType(1) << TB;
+
+	std::vector<uint32_t> H; // cumulative frequencies, H[0] = 0 and H[n] = TOTAL
+	std::vector<uint8_t> lut; // symbol for each target
+	TC n;
+
+	StaticStatisticsModule(TC _n = 256) : H(_n + 1, 0), lut(TOTAL, 0), n(_n)
+	{
+		if (n > 256) throw std::runtime_error("Alphabet too large for a static table");
+	}
+
+	StaticStatisticsModule(const StaticStatisticsModule&) = delete;
+	StaticStatisticsModule &operator=(const StaticStatisticsModule&) = delete;
+
+	void range(TS s, FreqType &l, FreqType &h) const
+	{
+		l = H[s];
+		h = H[s + 1];
+	}
+	FreqType total() const
+	{
+		return TOTAL;
+	}
+	TS symbol(FreqType target, FreqType &l, FreqType &h) const
+	{
+		TS s = lut[target];
+		range(s, l, h);
+		return s;
+	}
+	void init(TS s, FreqType incr = 1)
+	{}
+	void inc(TS s, FreqType inc = 1)
+	{}
+	FreqType frequency(TS s) const
+	{
+		return H[s + 1] - H[s];
+	}
+
+	// Sets the table from the frequencies F with a sum of TOTAL
+	void assign(const uint32_t *F)
+	{
+		for (TC i = 0; i < n; ++i) {
+			H[i + 1] = H[i] + F[i];
+			if (H[i + 1] > TOTAL) throw std::runtime_error("Corrupt static table");
+			std::fill(lut.begin() + H[i], lut.begin() + H[i + 1], (uint8_t)i);
+		}
+		if (H[n] != TOTAL) throw std::runtime_error("Corrupt static table");
+	}
+};
+
+// Tables are stored sparsely as the number of used symbols followed by (symbol, frequency) pairs.
+// Unused tables are stored as an empty list.
+template <int TB, typename TS, typename TC>
+void save_table(std::ostream &os, const CountingStatisticsModule<TB, TS, TC> &stat)
+{
+	std::vector<uint32_t> F(stat.n, 0);
+	if (stat.tot != 0) quantize_pow2(stat.C.data(), stat.n, stat.tot, TB, F.data());
+
+	uint16_t k = 0;
+	for (TC i = 0; i < stat.n; ++i) {
+		k += F[i] != 0;
+	}
+	os.write((const char*)&k, 2);
+	for (TC i = 0; i < stat.n; ++i) {
+		if (F[i] == 0) continue;
+		uint8_t s = i;
+		uint16_t f = F[i];
+		os.write((const char*)&s, 1);
+		os.write((const char*)&f, 2);
+	}
+}
+
+template <int TB, typename TS, typename TC>
+void load_table(std::istream &is, StaticStatisticsModule<TB, TS, TC> &stat)
+{
+	std::vector<uint32_t> F(stat.n, 0);
+	uint16_t k;
+	is.read((char*)&k, 2);
+	for (int i = 0; i < k; ++i) {
+		uint8_t s;
+		uint16_t f;
+		is.read((char*)&s, 1);
+		is.read((char*)&f, 2);
+		if (s >= stat.n) throw std::runtime_error("Corrupt static table");
+		F[s] = f;
+	}
+	if (k == 0) F[0] = stat.TOTAL;
+	if (!is) throw std::runtime_error("Unexpected end of static tables");
+	stat.assign(F.data());
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Benchmark of the entropy coder backends driven by an adaptive byte model, comparing arbitrary totals
+ * (AdaptiveStatisticsModule) against power-of-two totals (Pow2StatisticsModule).
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <stdint.h>
+
+#include "arith/coder.h"
+#include "arith/range.h"
+#include "arith/rans.h"
+#include "arith/stat_adaptive.h"
+#include "arith/stat_pow2.h"
+
+static const int NSYM = 1 << 23;
+static const int REPEAT = 3;
+
+template <typename E, typename D, typename S>
+void run(const char *name, const std::vector<unsigned char> &src)
+{
+	typedef std::chrono::high_resolution_clock clock;
+	double best_enc = 1e100, best_dec = 1e100;
+	std::size_t bytes = 0;
+	bool ok = true;
+
+	for (int r = 0; r < REPEAT; ++r) {
+		std::stringstream ss;
+		clock::time_point t0 = clock::now();
+		{
+			S stat(256);
+			for (int i = 0; i < 256; ++i) stat.init(i);
+			E e(ss);
+			for (int i = 0; i < src.size(); ++i) {
+				e(stat, src[i]);
+				stat.inc(src[i]);
+			}
+			e.flush();
+		}
+		clock::time_point t1 = clock::now();
+		bytes = ss.str().size();
+
+		std::vector<unsigned char> dst(src.size());
+		clock::time_point t2 = clock::now();
+		{
+			S stat(256);
+			for (int i = 0; i < 256; ++i) stat.init(i);
+			D d(ss);
+			for (int i = 0; i < dst.size(); ++i) {
+				dst[i] = d(stat);
+				stat.inc(dst[i]);
+			}
+		}
+		clock::time_point t3 = clock::now();
+		ok = ok && dst == src;
+
+		best_enc = std::min(best_enc, std::chrono::duration<double, std::nano>(t1 - t0).count() / src.size());
+		best_dec = std::min(best_dec, std::chrono::duration<double, std::nano>(t3 - t2).count() / src.size());
+	}
+	std::cout << std::setw(16) << name << std::fixed << std::setprecision(2) << std::setw(10) << best_enc << std::setw(10) << best_dec << std::setw(12) << bytes << (ok ? "" : "  MISMATCH") << std::endl;
+}
+
+template <typename E, typename D>
+void run_both(const char *name, const std::vector<unsigned char> &src)
+{
+	std::string n(name);
+	run<E, D, arith::AdaptiveStatisticsModule<uint64_t, uint32_t, uint32_t, E::FREQ_BITS>>((n + " adaptive").c_str(), src);
+	run<E, D, arith::Pow2StatisticsModule<>>((n + " pow2").c_str(), src);
+}
+
+int main()
+{
+	// skewed distribution, as it is typical for residuals
+	std::mt19937 rng(1);
+	std::geometric_distribution<int> dist(0.05);
+	std::vector<unsigned char> src(NSYM);
+	for (int i = 0; i < NSYM; ++i) src[i] = std::min(dist(rng), 255);
+
+	std::cout << std::setw(16) << "coder" << std::setw(10) << "enc ns" << std::setw(10) << "dec ns" << std::setw(12) << "bytes" << std::endl;
+	run_both<arith::Encoder<>, arith::Decoder<>>("arith", src);
+	run_both<arith::RangeEncoder, arith::RangeDecoder>("range", src);
+	run_both<arith::RansEncoder<>, arith::RansDecoder<>>("rans", src);
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Microbenchmark for the connectivity traversal on high-genus meshes: time of cbm::encode on a thick plate
+ * with a regular pattern of through-holes, so every hole adds a handle and the cut-border frequently splits and unites.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
+#include <stdint.h>
+
+#include "cbm/encoder.h"
+
+static const int REPEAT = 3;
+
+// Triangle mesh with the interface required by cbm::encode; edge e is corner e % 3 of face e / 3
+struct TriMesh {
+	typedef uint32_t Edge;
+
+	std::vector<uint32_t> orgs, twins;
+	std::vector<bool> remaining;
+	uint32_t nvtx, left, cur;
+
+	void add_tri(uint32_t a, uint32_t b, uint32_t c)
+	{
+		orgs.push_back(a); orgs.push_back(b); orgs.push_back(c);
+	}
+	void add_quad(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+	{
+		add_tri(a, b, c);
+		add_tri(a, c, d);
+	}
+	void link()
+	{
+		std::unordered_map<uint64_t, uint32_t> em;
+		twins.resize(orgs.size());
+		for (uint32_t e = 0; e < orgs.size(); ++e) {
+			twins[e] = e;
+			uint64_t a = orgs[e], b = orgs[next(e)];
+			auto it = em.find(b << 32 | a);
+			if (it != em.end()) {
+				twins[e] = it->second;
+				twins[it->second] = e;
+				em.erase(it);
+			} else {
+				em.emplace(a << 32 | b, e);
+			}
+		}
+		nvtx = *std::max_element(orgs.begin(), orgs.end()) + 1;
+	}
+	void reset(const std::vector<uint32_t> &_twins)
+	{
+		twins = _twins;
+		remaining.assign(orgs.size() / 3, true);
+		left = remaining.size();
+		cur = 0;
+	}
+
+	uint32_t num_vtx()
+	{
+		return nvtx;
+	}
+	Edge choose_tri()
+	{
+		while (!remaining[cur]) ++cur;
+		remaining[cur] = false;
+		--left;
+		return 3 * cur;
+	}
+	Edge choose_twin(Edge i, bool &success)
+	{
+		Edge a = twins[i];
+		success = a != i && remaining[a / 3];
+		if (!success) return Edge();
+		remaining[a / 3] = false;
+		--left;
+		return a;
+	}
+	bool empty()
+	{
+		return left == 0;
+	}
+	uint32_t org(Edge e)
+	{
+		return orgs[e];
+	}
+	Edge next(Edge e)
+	{
+		return e % 3 == 2 ? e - 2 : e + 1;
+	}
+	Edge twin(Edge e)
+	{
+		return twins[e];
+	}
+	void merge(Edge a, Edge b)
+	{
+		twins[a] = b;
+		twins[b] = a;
+	}
+	void split(Edge e)
+	{
+		twins[e] = e;
+	}
+	bool border(Edge e)
+	{
+		return twins[e] == e;
+	}
+	int num_edges(uint32_t f)
+	{
+		return 3;
+	}
+	uint32_t face(Edge e)
+	{
+		return e / 3;
+	}
+	int edge(Edge e)
+	{
+		return e % 3;
+	}
+};
+
+// Counts the operations instead of coding them
+struct Writer {
+	uint64_t ops, splits, unions;
+
+	Writer() : ops(0), splits(0), unions(0)
+	{}
+
+	void order(int i) {}
+	void initial(int ntri) { ++ops; }
+	void tri100(int ntri, uint32_t v0) { ++ops; }
+	void tri010(int ntri, uint32_t v0) { ++ops; }
+	void tri001(int ntri, uint32_t v0) { ++ops; }
+	void tri110(int ntri, uint32_t v0, uint32_t v1) { ++ops; }
+	void tri101(int ntri, uint32_t v0, uint32_t v1) { ++ops; }
+	void tri011(int ntri, uint32_t v0, uint32_t v1) { ++ops; }
+	void tri111(int ntri, uint32_t v0, uint32_t v1, uint32_t v2) { ++ops; }
+	void end() { ++ops; }
+	void border(cbm::OP bop = cbm::BORDER) { ++ops; }
+	void newvertex(int ntri) { ++ops; }
+	void connectforward(int ntri) { ++ops; }
+	void connectbackward(int ntri) { ++ops; }
+	void splitcutborder(int ntri, int i) { ++ops; ++splits; }
+	void cutborderunion(int ntri, int i, int p) { ++ops; ++unions; }
+	void nm(int ntri, uint32_t idx) { ++ops; }
+};
+
+struct AttrCoder {
+	void vtx(uint32_t f, int le) {}
+	void face(uint32_t f, int le) {}
+};
+
+// Plate of n x n cells with a one cell hole in every 3 x 3 block, made of a top and a bottom layer and walls around all rims
+void plate(TriMesh &mesh, uint32_t n)
+{
+	auto solid = [n] (int i, int j) { return i >= 0 && j >= 0 && i < n && j < n && !(i % 3 == 1 && j % 3 == 1); };
+	auto vtx = [n] (int i, int j, int layer) { return (uint32_t)(layer * (n + 1) * (n + 1) + i * (n + 1) + j); };
+
+	for (int i = 0; i < n; ++i) {
+		for (int j = 0; j < n; ++j) {
+			if (!solid(i, j)) continue;
+			uint32_t c[4][2] = { { vtx(i, j, 0), vtx(i, j, 1) }, { vtx(i + 1, j, 0), vtx(i + 1, j, 1) }, { vtx(i + 1, j + 1, 0), vtx(i + 1, j + 1, 1) }, { vtx(i, j + 1, 0), vtx(i, j + 1, 1) } };
+			mesh.add_quad(c[0][0], c[1][0], c[2][0], c[3][0]);
+			mesh.add_quad(c[3][1], c[2][1], c[1][1], c[0][1]);
+
+			// walls at the rims, the top edge u -> v is matched by v -> u
+			int ni[4] = { i, i + 1, i, i - 1 }, nj[4] = { j - 1, j, j + 1, j };
+			for (int k = 0; k < 4; ++k) {
+				if (solid(ni[k], nj[k])) continue;
+				uint32_t *u = c[k], *v = c[(k + 1) % 4];
+				mesh.add_quad(v[0], u[0], u[1], v[1]);
+			}
+		}
+	}
+	mesh.link();
+}
+
+int main()
+{
+	typedef std::chrono::high_resolution_clock clock;
+
+	std::cout << std::setw(8) << "n" << std::setw(10) << "genus" << std::setw(12) << "triangles" << std::setw(10) << "splits" << std::setw(10) << "unions" << std::setw(10) << "ms" << std::endl;
+	for (uint32_t n = 150; n <= 1200; n *= 2) {
+		TriMesh mesh;
+		plate(mesh, n);
+		std::vector<uint32_t> twins = mesh.twins;
+		uint32_t genus = ((n + 1) / 3) * ((n + 1) / 3); // one handle per hole
+
+		double best = 1e100;
+		Writer wr;
+		for (int r = 0; r < REPEAT; ++r) {
+			mesh.reset(twins);
+			wr = Writer();
+			AttrCoder ac;
+			clock::time_point t0 = clock::now();
+			cbm::encode<TriMesh, Writer, AttrCoder, uint32_t, uint32_t>(mesh, wr, ac);
+			clock::time_point t1 = clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+		}
+		std::cout << std::setw(8) << n << std::setw(10) << genus << std::setw(12) << mesh.orgs.size() / 3 << std::setw(10) << wr.splits << std::setw(10) << wr.unions << std::setw(10) << std::fixed << std::setprecision(1) << best << std::endl;
+	}
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Benchmark of the number parsing of the text readers: parse::real against strtod/strtof and against the
+ * accumulation with pow the OBJ machine used before, for coordinates as exporters write them.
+ * Also counts the results, which are not exactly rounded.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+#include "utils/parse.h"
+
+static const int NNUM = 1 << 20;
+static const int REPEAT = 3;
+
+// The former actions of the OBJ machine, including their disregard of the exponent sign
+float accumulate(const char *&p, const char *end)
+{
+	double sign = 1, val = 0, fraction = 0, denom = 1, exp = 0, expmul = 1;
+	p = parse::skip_blank(p, end);
+	if (p != end && (*p == '-' || *p == '+')) sign = *p++ == '-' ? -1 : 1;
+	for (; p != end && *p >= '0' && *p <= '9'; ++p) { val *= 10; val += *p - '0'; }
+	if (p != end && *p == '.') for (++p; p != end && *p >= '0' && *p <= '9'; ++p) { fraction *= 10; fraction += *p - '0'; denom *= 10; }
+	if (p != end && (*p == 'e' || *p == 'E')) {
+		for (p += 2; p != end && *p >= '0' && *p <= '9'; ++p) { exp *= 10; exp += *p - '0'; }
+		expmul = std::pow(10.0, exp);
+	}
+	val += fraction / denom; val *= sign * expmul;
+	return val;
+}
+
+template <typename F>
+F reference(const char *s)
+{
+	return sizeof(F) == 4 ? std::strtof(s, nullptr) : std::strtod(s, nullptr);
+}
+
+// ns per number and number of results, which differ from strtod/strtof
+template <typename F, typename P>
+double measure(const std::string &text, const std::vector<std::size_t> &offs, P &&parse, std::size_t &wrong)
+{
+	typedef std::chrono::high_resolution_clock clock;
+	std::vector<F> out(offs.size());
+	double best = 1e100;
+	for (int r = 0; r < REPEAT; ++r) {
+		clock::time_point t0 = clock::now();
+		const char *p = text.data(), *end = p + text.size();
+		for (std::size_t i = 0; i < out.size(); ++i) out[i] = parse(p, end);
+		clock::time_point t1 = clock::now();
+		best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / out.size());
+	}
+	wrong = 0;
+	for (std::size_t i = 0; i < out.size(); ++i) {
+		F ref = reference<F>(text.c_str() + offs[i]);
+		if (std::memcmp(&ref, &out[i], sizeof(F)) != 0) ++wrong;
+	}
+	return best;
+}
+
+template <typename F, typename P>
+void run(const char *name, const std::string &text, const std::vector<std::size_t> &offs, P &&parse)
+{
+	std::size_t wrong;
+	double ns = measure<F>(text, offs, parse, wrong);
+	std::cout << std::setw(14) << name << std::setw(10) << std::fixed << std::setprecision(2) << ns << std::setw(10) << wrong << std::endl;
+}
+
+int main()
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> coord(-100.f, 100.f);
+	std::uniform_real_distribution<double> unit(-1., 1.);
+	// formats of the exporters: fixed point, shortest float, full double, scientific with small magnitudes
+	struct { const char *fmt; bool small; } sets[] = { { "%.6f", false }, { "%.9g", false }, { "%.17g", false }, { "%.6e", true } };
+
+	std::cout << std::setw(14) << "parser" << std::setw(10) << "ns" << std::setw(10) << "inexact" << std::endl;
+	for (const auto &set : sets) {
+		std::string text;
+		std::vector<std::size_t> offs;
+		char buf[64];
+		for (int i = 0; i < NNUM; ++i) {
+			double v = set.small ? unit(rng) * std::pow(10., (int)(rng() % 9) - 6) : coord(rng);
+			int n = std::snprintf(buf, sizeof buf, set.fmt, v);
+			offs.push_back(text.size());
+			text.append(buf, n).push_back(i % 3 == 2 ? '\n' : ' ');
+		}
+		std::cout << set.fmt << std::endl;
+
+		auto strto = [] (const char *&p, const char *end) {
+			char *e;
+			float v = std::strtof(p, &e);
+			p = e;
+			return v;
+		};
+		auto real_float = [] (const char *&p, const char *end) {
+			float v = 0;
+			parse::real(p, end, v);
+			return v;
+		};
+		auto real_double = [] (const char *&p, const char *end) {
+			double v = 0;
+			parse::real(p, end, v);
+			return v;
+		};
+		auto strtod = [] (const char *&p, const char *end) {
+			char *e;
+			double v = std::strtod(p, &e);
+			p = e;
+			return v;
+		};
+		run<float>("accumulate", text, offs, accumulate);
+		run<float>("strtof", text, offs, strto);
+		run<float>("real<float>", text, offs, real_float);
+		run<double>("strtod", text, offs, strtod);
+		run<double>("real<double>", text, offs, real_double);
+	}
+}
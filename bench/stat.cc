@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Microbenchmark for the adaptive statistics module: per-symbol cost of the model updates (total + inc),
+ * of the model side of encoding (range + total + inc) and of decoding (total + symbol + inc) across alphabet sizes.
+ * The tight limit forces frequent rescaling.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <stdint.h>
+
+#include "arith/stat_adaptive.h"
+
+static const int NSYM = 1 << 22;
+static const int REPEAT = 3;
+
+enum Mode { INC, ENC, DEC };
+
+template <typename S>
+double measure(Mode mode, uint32_t n, const std::vector<uint32_t> &syms, uint64_t &sink)
+{
+	typedef std::chrono::high_resolution_clock clock;
+	typename S::FreqType l, h;
+
+	S stat(n);
+	for (uint32_t i = 0; i < n; ++i) stat.init(i);
+	clock::time_point t0 = clock::now();
+	for (int i = 0; i < syms.size(); ++i) {
+		typename S::SymType s = syms[i];
+		typename S::FreqType t = stat.total();
+		if (mode == ENC) {
+			stat.range(s, l, h);
+			sink += l + h;
+		} else if (mode == DEC) {
+			s = stat.symbol(std::min(t - 1, (t >> 1) + (s & 0xff)), l, h);
+			sink += l + h;
+		}
+		sink += t;
+		stat.inc(s);
+	}
+	clock::time_point t1 = clock::now();
+	return std::chrono::duration<double, std::nano>(t1 - t0).count() / syms.size();
+}
+
+template <typename S>
+void run(const char *name, uint32_t n, const std::vector<uint32_t> &syms)
+{
+	uint64_t sink = 0;
+	std::cout << std::setw(8) << name << std::setw(8) << n << std::fixed << std::setprecision(2);
+	for (int m = INC; m <= DEC; ++m) {
+		double best = 1e100;
+		for (int r = 0; r < REPEAT; ++r) best = std::min(best, measure<S>((Mode)m, n, syms, sink));
+		std::cout << std::setw(10) << best;
+	}
+	std::cout << (sink == 42 ? " " : "") << std::endl;
+}
+
+int main()
+{
+	std::mt19937 rng(1);
+	std::cout << std::setw(8) << "limit" << std::setw(8) << "n" << std::setw(10) << "inc ns" << std::setw(10) << "enc ns" << std::setw(10) << "dec ns" << std::endl;
+	for (uint32_t n = 4; n <= 65536; n *= 4) {
+		// skewed distribution, as it is typical for residuals
+		std::geometric_distribution<uint32_t> dist(4.0 / n);
+		std::vector<uint32_t> syms(NSYM);
+		for (int i = 0; i < NSYM; ++i) syms[i] = std::min(dist(rng), n - 1);
+
+		run<arith::AdaptiveStatisticsModule<>>("2^62", n, syms);
+		run<arith::AdaptiveStatisticsModule<uint64_t, uint32_t, uint32_t, 18>>("2^18", n, syms);
+	}
+}
@@ -17,9 +17,9 @@
 
 #pragma once
 
-#include <deque>
-#include <list>
 #include <vector>
+#include <limits>
+#include <stdint.h>
 
 #include "base.h"
 
@@ -46,33 +46,64 @@ std::ostream &operator<<(std::ostream &os, const DataTpl<T, V> &d)
 	return os << d.idx << " [" << (T)d << "]";
 }
 
+// Parts are index-linked lists of elements, which live in a shared node pool, so the traversal does not allocate once the pool has grown.
+// Every element carries a part id and a label, such that the labels of a part are consecutive, so the position of a vertex,
+// which is on the cut-border only once, is found in constant time. Splits relabel the smaller range. Unions do not touch
+// the elements of the other part, but retire its record into a route, which maps its labels into the united part;
+// lookups follow the routes and compress them.
 template <typename T, typename V>
 struct CutBorder {
 	typedef DataTpl<T, V> Data;
-	typedef std::list<Data> Elements;
-	struct Part : Elements {
+	typedef uint32_t Idx;
+	static const Idx NIL = ~Idx(0);
+
+	struct Node {
+		Data d;
+		Idx prev, next;
+		Idx part; // id of a part record, which may be a route
+		int64_t label;
+	};
+	struct Part {
+		Idx head, tail;
+		std::size_t size;
+		int64_t first; // label of the head
+		Idx level; // position on the part stack
 		bool isEdgeBegin;
-		Part() : isEdgeBegin(true)
+
+		// route of a record retired by a union: labels below thr are shifted by dlo, the others by dhi
+		Idx route;
+		int64_t thr, dlo, dhi;
+
+		Part() : head(NIL), tail(NIL), size(0), first(0), level(0), isEdgeBegin(true), route(NIL)
 		{}
 
 		std::size_t num_edges()
 		{
-			return this->size() - (isEdgeBegin ? 0 : 1);
+			return size - (isEdgeBegin ? 0 : 1);
 		}
 	};
-	typedef std::deque<Part> Parts;
-	Parts parts;
-	Data *first, *second;
+	struct Vertex {
+		Idx node; // the element of the vertex if it is on the cut-border once and the element is known, NIL otherwise
+		unsigned char count;
+		Vertex() : node(NIL), count(0)
+		{}
+	};
+
+	std::vector<Idx> parts; // stack of part ids
+	std::vector<Part> pool; // part records and routes
+	std::vector<Node> nodes;
+	Idx free, free_parts; // singly linked lists of unused nodes and part records
+	Data *first, *second; // valid until the next operation
 
-	// acceleration structure for fast lookup if a vertex is currently on the cutboder
-	std::vector<unsigned char> vertices;
+	// acceleration structure for fast lookup if and where a vertex is currently on the cutboder
+	std::vector<Vertex> vertices;
 
-	CutBorder(V num_vtx = 0) : vertices(num_vtx, 0)
+	CutBorder(V num_vtx = 0) : free(NIL), free_parts(NIL), vertices(num_vtx)
 	{}
 
 	Part &cur_part()
 	{
-		return parts.back();
+		return pool[parts.back()];
 	}
 
 	bool atEnd()
@@ -83,72 +114,89 @@ struct CutBorder {
 	void traverseStep(Data &v0, Data &v1)
 	{
 		Part &part = cur_part();
-		v0 = part.back();
-		v1 = part.front();
+		v0 = nodes[part.tail].d;
+		v1 = nodes[part.head].d;
 	}
 
 	const Data &left() // previous on cut-border
 	{
-		return *(++cur_part().rbegin());
+		return nodes[nodes[cur_part().tail].prev].d;
 	}
 	const Data &right() // next on cut-border
 	{
-		return cur_part().front();
+		return nodes[cur_part().head].d;
 	}
 
-	void activate_vertex(V i)
+	void activate_vertex(Idx n)
 	{
-		++vertices[i];
+		Vertex &v = vertices[nodes[n].d.idx];
+		v.node = v.count++ == 0 ? n : NIL;
 	}
 	void deactivate_vertex(V i)
 	{
-		--vertices[i];
+		Vertex &v = vertices[i];
+		--v.count;
+		v.node = NIL;
 	}
 	bool on_cut_border(V i)
 	{
-#ifdef HAVE_ASSERT
-		assert_ge(vertices[i], 0);
-#endif
-		return vertices[i] != 0;
+		return vertices[i].count != 0;
 	}
 
-	typename Elements::iterator get_element(int i, int p = 0)
+	Idx get_element(int i, int p = 0)
 	{
-		Part &part = parts[parts.size() - 1 - p];
+		Part &part = pool[parts[parts.size() - 1 - p]];
 
-		if (i > 0)
-			return std::next(part.begin(), i - 1);
-		else
-			return std::prev(part.end(), -i + 1);
+		Idx it;
+		if (i > 0) {
+			it = part.head;
+			for (int j = 1; j < i; ++j) it = nodes[it].next;
+		} else {
+			it = part.tail;
+			for (int j = 0; j < -i; ++j) it = nodes[it].prev;
+		}
+		return it;
 	}
-	typename Elements::iterator find_element(Data v, int &i, int &p)
+	Idx find_element(Data v, int &i, int &p)
 	{
+		Vertex &vtx = vertices[v.idx];
+		if (vtx.node != NIL) {
+			// same result as the search below, which finds the element from the nearer end, preferring the front
+			Part &part = pool[resolve(vtx.node)];
+			p = parts.size() - 1 - part.level;
+			int64_t a = nodes[vtx.node].label - part.first, b = part.size - 1 - a;
+			i = a <= b ? a + 1 : -b;
+			return vtx.node;
+		}
+
 		// search vertex in both directions
-		typename Parts::reverse_iterator part = parts.rbegin();
-		typename Elements::reverse_iterator l = part->rbegin();
-		typename Elements::iterator r = part->begin();
+		std::size_t part = parts.size() - 1;
+		Idx l = pool[parts[part]].tail;
+		Idx r = pool[parts[part]].head;
 
 		i = 0; p = 0;
 		while (1) {
-			if (r->idx == v.idx) {
+			if (nodes[r].d.idx == v.idx) {
 				++i;
+				if (vtx.count == 1) vtx.node = r;
 				return r;
-			} else if (l->idx == v.idx) {
+			} else if (nodes[l].d.idx == v.idx) {
 				i = -i;
-				return std::prev(l.base());
+				if (vtx.count == 1) vtx.node = l;
+				return l;
 			}
 
-			if (std::prev(l.base()) == r || l.base() == r) {
+			if (l == r || nodes[l].next == r) {
 				++p;
-				++part;
 #ifdef HAVE_ASSERT
-				assert(part != parts.rend());
+				assert(part != 0);
 #endif
-				r = part->begin();
-				l = part->rbegin();
+				--part;
+				r = pool[parts[part]].head;
+				l = pool[parts[part]].tail;
 				i = 0;
 			} else {
-				++r; ++l;
+				r = nodes[r].next; l = nodes[l].prev;
 				++i;
 			}
 		}
@@ -156,41 +204,35 @@ struct CutBorder {
 
 	void initial(Data v0, Data v1, Data v2)
 	{
-		parts.emplace_back();
-		Part &part = cur_part();
-		part.push_back(v0); activate_vertex(v0.idx);
-		part.push_back(v1); activate_vertex(v1.idx);
-		part.push_back(v2); activate_vertex(v2.idx);
+		Idx pid = push_part();
+		push_back(pid, v0);
+		push_back(pid, v1);
+		push_back(pid, v2);
 	}
 
 	void newVertex(Data v)
 	{
+		push_back(parts.back(), v);
 		Part &part = cur_part();
-		first = &part.back();
-		part.push_back(v); activate_vertex(v.idx);
-		second = &part.back();
+		second = &nodes[part.tail].d;
+		first = &nodes[nodes[part.tail].prev].d;
 	}
 	Data connectForward(OP &op)
 	{
 		Part &part = cur_part();
-		Data d = *(++part.begin());
+		Data d = nodes[nodes[part.head].next].d;
 		if (!part.isEdgeBegin) {
 			op = border();
 			return Data();
 		} else if (istri()) {
-			typename Elements::iterator it = part.begin();
-			deactivate_vertex((it++)->idx);
-			deactivate_vertex((it++)->idx);
-			deactivate_vertex((it++)->idx);
-
-			parts.pop_back();
+			while (part.size != 0) pop_front(part);
+			pop_part();
 			op = CLOSE;
 		} else {
-			deactivate_vertex(part.front().idx);
-			part.pop_front();
+			pop_front(part);
 
 			op = CONNFWD;
-			first = &cur_part().back();
+			first = &nodes[cur_part().tail].d;
 		}
 		return d;
 	}
@@ -199,19 +241,18 @@ struct CutBorder {
 		Part &part = cur_part();
 
 		// NOTE: border and close operations are always renamed to connect forward
-		deactivate_vertex(part.back().idx);
-		part.pop_back();
+		pop_back(part);
 
 		op = CONNBWD;
-		first = &part.back();
+		first = &nodes[part.tail].d;
 
-		return part.back();
+		return *first;
 	}
 
 	bool istri()
 	{
 		Part &part = cur_part();
-		return part.num_edges() == 3 && part.size() == 3;
+		return part.num_edges() == 3 && part.size == 3;
 	}
 
 	OP border()
@@ -219,26 +260,22 @@ struct CutBorder {
 		Part &part = cur_part();
 		if (part.num_edges() == 1) {
 #ifdef HAVE_ASSERT
-			assert_eq(part.size(), 2);
+			assert_eq(part.size, 2);
 #endif
-			typename Elements::iterator it = part.begin();
-			deactivate_vertex((it++)->idx);
-			deactivate_vertex((it++)->idx);
-			parts.pop_back();
+			while (part.size != 0) pop_front(part);
+			pop_part();
 		} else {
-			Data endvtx = part.back();
+			Data endvtx = nodes[part.tail].d;
 
 			bool rename = !part.isEdgeBegin;
 
-			deactivate_vertex(part.back().idx);
-			part.pop_back();
+			pop_back(part);
 
 			if (!part.isEdgeBegin) {
-				deactivate_vertex(part.front().idx);
-				part.pop_front();
+				pop_front(part);
 			}
 
-			part.push_front(endvtx); activate_vertex(endvtx.idx);
+			push_front(parts.back(), endvtx);
 			part.isEdgeBegin = false;
 
 			if (rename) return CONNFWD;
@@ -247,53 +284,102 @@ struct CutBorder {
 		return BORDER;
 	}
 
-	Data splitCutBorder(typename Elements::iterator it)
+	Data splitCutBorder(Idx it)
 	{
-		Part &part = cur_part();
-		Data gate = part.back();
-		deactivate_vertex(gate.idx);
-		part.pop_back();
+		Data res = nodes[it].d;
+		Idx pid = parts.back();
+		Data gate = nodes[pool[pid].tail].d;
+		pop_back(pool[pid]);
+		resolve(it);
+
+		// the smaller range moves to a new record, the elements in front of it form the part on top of the stack
+		Idx npid = new_part();
+		Part &part = pool[pid], &np = pool[npid];
+		int64_t thr = nodes[it].label;
+		std::size_t n = thr - part.first;
+		Idx prefix, suffix;
+		if (n <= part.size - n) {
+			prefix = npid; suffix = pid;
+			if (n != 0) {
+				np.head = part.head;
+				np.tail = nodes[it].prev;
+				np.first = part.first;
+				relabel(npid, n);
+				part.head = it;
+				nodes[np.tail].next = NIL;
+				nodes[it].prev = NIL;
+			}
+			part.first = thr;
+		} else {
+			prefix = pid; suffix = npid;
+			np.head = it;
+			np.tail = part.tail;
+			np.first = thr;
+			relabel(npid, part.size - n);
+			part.tail = nodes[it].prev;
+			nodes[part.tail].next = NIL;
+			nodes[it].prev = NIL;
+		}
+		Part &pp = pool[prefix], &sp = pool[suffix];
+		sp.size = part.size - n;
+		pp.size = n;
+		pp.isEdgeBegin = part.isEdgeBegin;
+		sp.isEdgeBegin = true;
 
-		parts.emplace_back();
-		Part &newpart = cur_part();
-		newpart.splice(newpart.begin(), part, part.begin(), it);
-		part.push_back(gate); activate_vertex(gate.idx);
-		newpart.push_back(*it); activate_vertex(it->idx);
-		std::swap(part.isEdgeBegin, newpart.isEdgeBegin);
+		sp.level = part.level;
+		parts[sp.level] = suffix;
+		pp.level = parts.size();
+		parts.push_back(prefix);
 
-		second = &newpart.back();
-		first = &part.back();
+		push_back(suffix, gate);
+		push_back(prefix, res);
 
-		return *it;
+		second = &nodes[pool[prefix].tail].d;
+		first = &nodes[pool[suffix].tail].d;
+
+		return res;
 	}
 	Data splitCutBorder(int i)
 	{
 		return splitCutBorder(get_element(i));
 	}
 
-	Data cutBorderUnion(typename Elements::iterator it, int p)
+	Data cutBorderUnion(Idx it, int p)
 	{
-		Part &part = cur_part();
-		Data gate = part.back();
-		deactivate_vertex(gate.idx);
-		part.pop_back();
-
-		Part &otherpart = parts[parts.size() - 1 - p];
-		part.push_back(gate); activate_vertex(gate.idx);
-		first = &part.back();
-		part.splice(part.end(), otherpart, it, otherpart.end());
-		part.splice(part.end(), otherpart, otherpart.begin(), otherpart.end()); // it is now end
-		part.push_back(*it); activate_vertex(it->idx);
-		second = &part.back();
-
-		// move part to front
-		for (typename Parts::iterator it = parts.begin() + (parts.size() - 1 - p); it < parts.end() - 1; ++it) {
-			it->swap(it[1]);
-			std::swap(it->isEdgeBegin, it[1].isEdgeBegin);
+		Data res = nodes[it].d;
+		Idx pid = parts.back(), opid = parts[parts.size() - 1 - p];
+		Part &part = pool[pid];
+		Data gate = nodes[part.tail].d;
+		pop_back(part);
+		push_back(pid, gate);
+		Idx gatenode = part.tail;
+		resolve(it);
+
+		// append the other part, rotated such that it starts at it
+		Part &otherpart = pool[opid];
+		int64_t thr = nodes[it].label;
+		int64_t base = part.first + part.size; // label of it in the united part
+		Idx itprev = nodes[it].prev;
+		if (itprev != NIL) {
+			nodes[otherpart.tail].next = otherpart.head;
+			nodes[otherpart.head].prev = otherpart.tail;
+			nodes[itprev].next = NIL;
 		}
-		parts.pop_back();
+		nodes[part.tail].next = it;
+		nodes[it].prev = part.tail;
+		part.tail = itprev != NIL ? itprev : otherpart.tail;
+		part.size += otherpart.size;
+
+		// the other part is empty now
+		int64_t dhi = base - thr, dlo = base + otherpart.size - thr;
+		erase_part(opid, false);
+		retire(opid, pid, thr, dlo, dhi);
 
-		return *it;
+		push_back(pid, res);
+		second = &nodes[pool[pid].tail].d;
+		first = &nodes[gatenode].d;
+
+		return res;
 	}
 	Data cutBorderUnion(int i, int p)
 	{
@@ -303,9 +389,9 @@ struct CutBorder {
 	bool findAndUpdate(Data v, int &i, int &p, OP &op)
 	{
 		if (!on_cut_border(v.idx)) return false;
-		typename Elements::iterator it = find_element(v, i, p);
+		Idx it = find_element(v, i, p);
 #ifdef HAVE_ASSERT
-		assert_eq(get_element(i, p)->idx, v.idx);
+		assert_eq(get_element(i, p), it);
 #endif
 
 		if (p > 0) {
@@ -316,9 +402,9 @@ struct CutBorder {
 #endif
 		} else {
 			Part &part = cur_part();
-			if (part.isEdgeBegin && (++part.begin())->idx == v.idx) {
+			if (part.isEdgeBegin && nodes[nodes[part.head].next].d.idx == v.idx) {
 				connectForward(op);
-			} else if ((++part.rbegin())->idx == v.idx) {
+			} else if (nodes[nodes[part.tail].prev].d.idx == v.idx) {
 				connectBackward(op);
 			} else {
 				op = SPLIT;
@@ -330,6 +416,148 @@ struct CutBorder {
 		}
 		return true;
 	}
+
+private:
+	Idx alloc(const Data &d)
+	{
+		Idx n;
+		if (free != NIL) {
+			n = free;
+			free = nodes[n].next;
+		} else {
+			n = nodes.size();
+			nodes.emplace_back();
+		}
+		nodes[n].d = d;
+		return n;
+	}
+	void release(Idx n)
+	{
+		nodes[n].next = free;
+		free = n;
+	}
+	// insert an element and activate its vertex
+	void push_back(Idx pid, const Data &d)
+	{
+		Idx n = alloc(d);
+		Part &part = pool[pid];
+		nodes[n].prev = part.tail;
+		nodes[n].next = NIL;
+		nodes[n].part = pid;
+		nodes[n].label = part.first + part.size;
+		if (part.tail != NIL) nodes[part.tail].next = n;
+		else part.head = n;
+		part.tail = n;
+		++part.size;
+		activate_vertex(n);
+	}
+	void push_front(Idx pid, const Data &d)
+	{
+		Idx n = alloc(d);
+		Part &part = pool[pid];
+		nodes[n].prev = NIL;
+		nodes[n].next = part.head;
+		nodes[n].part = pid;
+		nodes[n].label = --part.first;
+		if (part.head != NIL) nodes[part.head].prev = n;
+		else part.tail = n;
+		part.head = n;
+		++part.size;
+		activate_vertex(n);
+	}
+	// remove an element and deactivate its vertex
+	void pop_back(Part &part)
+	{
+		Idx n = part.tail;
+		deactivate_vertex(nodes[n].d.idx);
+		part.tail = nodes[n].prev;
+		if (part.tail != NIL) nodes[part.tail].next = NIL;
+		else part.head = NIL;
+		--part.size;
+		release(n);
+	}
+	void pop_front(Part &part)
+	{
+		Idx n = part.head;
+		deactivate_vertex(nodes[n].d.idx);
+		part.head = nodes[n].next;
+		if (part.head != NIL) nodes[part.head].prev = NIL;
+		else part.tail = NIL;
+		--part.size;
+		++part.first;
+		release(n);
+	}
+
+	// moves the first n elements, starting at the head of a record, into it
+	void relabel(Idx pid, std::size_t n)
+	{
+		Idx it = pool[pid].head;
+		for (std::size_t k = 0; k < n; ++k, it = nodes[it].next) {
+			nodes[it].part = pid;
+			nodes[it].label = pool[pid].first + k;
+		}
+	}
+
+	// follows the routes of an element to its part and compresses them
+	Idx resolve(Idx n)
+	{
+		Idx pid = nodes[n].part;
+		int64_t label = nodes[n].label;
+		while (pool[pid].route != NIL) {
+			Part &r = pool[pid];
+			label += label < r.thr ? r.dlo : r.dhi;
+			pid = r.route;
+		}
+		nodes[n].part = pid;
+		nodes[n].label = label;
+		return pid;
+	}
+
+	// part records are reused, unless they became routes
+	Idx new_part()
+	{
+		Idx pid;
+		if (free_parts != NIL) {
+			pid = free_parts;
+			free_parts = pool[pid].head;
+			pool[pid] = Part();
+		} else {
+			pid = pool.size();
+			pool.emplace_back();
+		}
+		return pid;
+	}
+	Idx push_part()
+	{
+		Idx pid = new_part();
+		pool[pid].level = parts.size();
+		parts.push_back(pid);
+		return pid;
+	}
+	void pop_part()
+	{
+		erase_part(parts.back());
+	}
+	void erase_part(Idx pid, bool reuse = true)
+	{
+		for (Idx l = pool[pid].level + 1; l < parts.size(); ++l) {
+			parts[l - 1] = parts[l];
+			pool[parts[l - 1]].level = l - 1;
+		}
+		parts.pop_back();
+		if (reuse) {
+			pool[pid].head = free_parts;
+			free_parts = pid;
+		}
+	}
+	void retire(Idx pid, Idx route, int64_t thr, int64_t dlo, int64_t dhi)
+	{
+		Part &r = pool[pid];
+		r.route = route;
+		r.thr = thr;
+		r.dlo = dlo;
+		r.dhi = dhi;
+	}
 };
 
 }
@@ -11,7 +11,9 @@
 
 #include <limits>
 #include <vector>
+#include <algorithm>
 
+#include "utils/threads.h"
 #include "io.h"
 #include "transform.h"
 #include "prediction.h"
@@ -20,6 +22,11 @@ namespace hry {
 namespace attrcode {
 
 static const mesh::attridx_t UNSET = std::numeric_limits<mesh::attridx_t>::max();
+
+// List selection of a coder: all lists with their regions interleaved, no list, or a single list (separate streams)
+static const mesh::listidx_t ALL = std::numeric_limits<mesh::listidx_t>::max();
+static const mesh::listidx_t NONE = ALL - 1;
+
 struct GlobalHistory {
 	std::vector<mesh::attridx_t> tidxlist;
 	mesh::attridx_t tidx;
@@ -110,9 +117,44 @@ struct AbsAttrCoder {
 	std::vector<bool> face_is_encoded;
 	int curparal, curneigh, curhist;
 	mesh::Mesh &mesh;
+	mesh::listidx_t only;
+	// scratch of each list: candidates, prediction and their sum; owned by the coder, so that several coders can predict in parallel
+	std::vector<mixing::Array> mcache, maccu, mbig;
+
+	AbsAttrCoder(mesh::Mesh &_mesh, mesh::listidx_t _only = ALL) : mesh(_mesh), vtx_is_encoded(_mesh.attrs.num_vtx(), false), face_is_encoded(_mesh.attrs.num_face(), false), only(_only)
+	{
+		for (mesh::listidx_t l = 0; l < mesh.attrs.size(); ++l) {
+			const mixing::Fmt &fmt = mesh.attrs[l].fmt();
+			mcache.emplace_back(fmt);
+			maccu.emplace_back(fmt);
+			mbig.emplace_back(fmt.big());
+			maccu.back().resize(1);
+			mbig.back().resize(1);
+		}
+	}
 
-	AbsAttrCoder(mesh::Mesh &_mesh) : mesh(_mesh), vtx_is_encoded(_mesh.attrs.num_vtx(), false), face_is_encoded(_mesh.attrs.num_face(), false)
-	{}
+	mixing::Array &cache(mesh::listidx_t l)
+	{
+		return mcache[l];
+	}
+	mixing::Array &accu(mesh::listidx_t l)
+	{
+		return maccu[l];
+	}
+	mixing::Array &big(mesh::listidx_t l)
+	{
+		return mbig[l];
+	}
+
+	bool codes(mesh::listidx_t l) const
+	{
+		return only == ALL || only == l;
+	}
+	bool codes_target(mesh::attr::Target t) const
+	{
+		if (only == ALL) return true;
+		return only < mesh.attrs.size() && mesh.attrs[only].target == t;
+	}
 
 	void use_paral(mesh::vtxidx_t v0, mesh::vtxidx_t v1, mesh::vtxidx_t vo, mesh::regidx_t r)
 	{
@@ -122,13 +164,14 @@ struct AbsAttrCoder {
 
 		for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_vtx_reg(r); ++a) {
 			mesh::listidx_t l = mesh.attrs.binding_reg_vtxlist(r, a);
+			if (!codes(l)) continue;
 
 			// fetch values
 			mixing::View d0 = mesh.attrs[l][mesh.attrs.binding_vtx_attr(v0, a)], d1 = mesh.attrs[l][mesh.attrs.binding_vtx_attr(v1, a)], dop = mesh.attrs[l][mesh.attrs.binding_vtx_attr(vo, a)];
 
 			// add prediction
-			if (mesh.attrs[l].cache().size() <= curparal) mesh.attrs[l].cache().resize(curparal + 1);
-			mesh.attrs[l].cache()[curparal].setq([] (int q, const auto d0c, const auto d1c, const auto doc) { return pred::predict(d0c, d1c, doc, q); }, d0, d1, dop);
+			if (cache(l).size() <= curparal) cache(l).resize(curparal + 1);
+			cache(l)[curparal].setq([] (int q, const auto d0c, const auto d1c, const auto doc) { return pred::predict(d0c, d1c, doc, q); }, d0, d1, dop);
 		}
 		++curparal;
 	}
@@ -142,13 +185,14 @@ struct AbsAttrCoder {
 
 		for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_corner_reg(r); ++a) {
 			mesh::listidx_t l = mesh.attrs.binding_reg_cornerlist(r, a);
+			if (!codes(l)) continue;
 
 			// fetch values
 			mixing::View d0 = mesh.attrs[l][mesh.attrs.binding_corner_attr(f, lv, a)];
 
 			// add prediction
-			if (mesh.attrs[l].cache().size() <= curhist) mesh.attrs[l].cache().resize(curhist + 1);
-			mesh.attrs[l].cache()[curhist].setq([] (int q, const auto d0c) { return pred::predict_face(d0c, q); }, d0);
+			if (cache(l).size() <= curhist) cache(l).resize(curhist + 1);
+			cache(l)[curhist].setq([] (int q, const auto d0c) { return pred::predict_face(d0c, q); }, d0);
 		}
 		++curhist;
 	}
@@ -182,15 +226,15 @@ struct AbsAttrCoder {
 	void get_prediction(mesh::listidx_t l, int num_parts)
 	{
 		// compute average
-		mixing::View avg = mesh.attrs[l].big()[0];
+		mixing::View avg = big(l)[0];
 		avg.set([] (const auto) { return 0; }, avg);
 		for (int i = 0; i < num_parts; ++i) {
-			avg.sets([] (const auto cur, const auto val) { return cur + val; }, avg, mesh.attrs[l].cache()[i]);
+			avg.sets([] (const auto cur, const auto val) { return cur + val; }, avg, cache(l)[i]);
 		}
 		avg.set([num_parts] (const auto cur) { return num_parts == 0 ? decltype(cur)(0) : transform::divround(cur, (decltype(cur))num_parts); }, avg);
 
 		// selection (without quantization or integral values: average; with quantization: value closest to quantization)
-		mixing::View res = mesh.attrs[l].accu()[0];
+		mixing::View res = accu(l)[0];
 		if (num_parts == 0) {
 			res.set([] (const auto x) { return decltype(x)(0); }, res);
 		} else {
@@ -202,7 +246,7 @@ struct AbsAttrCoder {
 					decltype(resv) resdiff = avgv > resv ? avgv - resv : resv - avgv;
 					decltype(predv) preddiff = avgv > predv ? avgv - predv : predv - avgv;
 					return resdiff < preddiff ? resv : predv;
-				}, res, mesh.attrs[l].cache()[i], avg);
+				}, res, cache(l)[i], avg);
 			}
 		}
 	}
@@ -220,7 +264,7 @@ struct AbsAttrCoder {
 
 		for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_vtx_reg(r); ++a) {
 			mesh::listidx_t l = mesh.attrs.binding_reg_vtxlist(r, a);
-			get_prediction(l, num_paral);
+			if (codes(l)) get_prediction(l, num_paral);
 		}
 	}
 
@@ -232,13 +276,14 @@ struct AbsAttrCoder {
 
 		for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_face_reg(r); ++a) {
 			mesh::listidx_t l = mesh.attrs.binding_reg_facelist(r, a);
+			if (!codes(l)) continue;
 
 			// fetch values
 			mixing::View d0 = mesh.attrs[l][mesh.attrs.binding_face_attr(f, a)];
 
 			// add prediction
-			if (mesh.attrs[l].cache().size() <= curneigh) mesh.attrs[l].cache().resize(curneigh + 1);
-			mesh.attrs[l].cache()[curneigh].setq([] (int q, const auto d0c) { return pred::predict_face(d0c, q); }, d0);
+			if (cache(l).size() <= curneigh) cache(l).resize(curneigh + 1);
+			cache(l)[curneigh].setq([] (int q, const auto d0c) { return pred::predict_face(d0c, q); }, d0);
 		}
 		++curneigh;
 	}
@@ -265,7 +310,7 @@ struct AbsAttrCoder {
 
 		for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_face_reg(r); ++a) {
 			mesh::listidx_t l = mesh.attrs.binding_reg_facelist(r, a);
-			get_prediction(l, num_neigh);
+			if (codes(l)) get_prediction(l, num_neigh);
 		}
 	}
 
@@ -283,7 +328,7 @@ struct AbsAttrCoder {
 
 		for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_corner_reg(r); ++a) {
 			mesh::listidx_t l = mesh.attrs.binding_reg_cornerlist(r, a);
-			get_prediction(l, num_hist);
+			if (codes(l)) get_prediction(l, num_hist);
 		}
 	}
 };
@@ -297,13 +342,16 @@ struct AttrCoder : AbsAttrCoder {
 	std::vector<mesh::conn::fepair> order;
 	std::vector<mesh::conn::fepair> order_f;
 
-	AttrCoder(mesh::Mesh &_mesh, WR &_wr) : mesh(_mesh), wr(_wr), AbsAttrCoder(_mesh), ghist(_mesh.attrs.size()), lhist(mesh.attrs.num_bindings_corner)
+	AttrCoder(mesh::Mesh &_mesh, WR &_wr, mesh::listidx_t _only = ALL) : mesh(_mesh), wr(_wr), AbsAttrCoder(_mesh, _only), ghist(_mesh.attrs.size())
 	{
 		for (mesh::listidx_t i = 0; i < mesh.attrs.size(); ++i) {
-			ghist[i].resize(mesh.attrs[i].size());
+			if (codes(i)) ghist[i].resize(mesh.attrs[i].size());
 		}
-		for (mesh::listidx_t i = 0; i < mesh.attrs.num_bindings_corner; ++i) {
-			lhist[i].resize(mesh.attrs.num_vtx());
+		if (codes_target(mesh::attr::CORNER)) {
+			lhist.resize(mesh.attrs.num_bindings_corner);
+			for (mesh::listidx_t i = 0; i < mesh.attrs.num_bindings_corner; ++i) {
+				lhist[i].resize(mesh.attrs.num_vtx());
+			}
 		}
 	}
 
@@ -318,17 +366,24 @@ struct AttrCoder : AbsAttrCoder {
 		order_f.push_back(e);
 	}
 
-	void vtx_post(mesh::faceidx_t f, mesh::ledgeidx_t le)
+	// Residual of the value idx of list l against the prediction of the coder c
+	void residual(AbsAttrCoder &c, mesh::listidx_t l, mesh::attridx_t idx, mixing::View dst)
+	{
+		dst.setq([] (int q, const auto raw, const auto pred) { return pred::encodeDelta(raw, pred, q); }, mesh.attrs[l][idx], c.accu(l)[0]);
+	}
+
+	// The *_code functions code an element of the order, res(a, l, idx) returns the residual of its binding a
+	template <typename R>
+	void vtx_code(mesh::conn::fepair e, R &&res)
 	{
-		mesh::conn::fepair e(f, le);
 		mesh::vtxidx_t v = mesh.conn.org(e);
 		mesh::regidx_t r = mesh.attrs.vtx2reg(v);
 
-		AbsAttrCoder::vtx(f, le);
-		wr.reg_vtx(r);
+		if (only == ALL) wr.reg_vtx(r);
 
 		for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_vtx_reg(r); ++a) {
 			mesh::listidx_t l = mesh.attrs.binding_reg_vtxlist(r, a);
+			if (!codes(l)) continue;
 			mesh::attridx_t idx = mesh.attrs.binding_vtx_attr(v, a);
 
 			mesh::attridx_t tidx = ghist[l].lget_set(idx);
@@ -337,20 +392,19 @@ struct AttrCoder : AbsAttrCoder {
 				continue;
 			}
 
-			mixing::View res = mesh.attrs[l].accu()[0];
-			res.setq([] (int q, const auto raw, const auto pred) { return pred::encodeDelta(raw, pred, q); }, mesh.attrs[l][idx], res);
-			wr.attr_data(res, l);
+			wr.attr_data(res(a, l, idx), l);
 		}
 	}
-	void face_post(mesh::faceidx_t f, mesh::ledgeidx_t le)
+	template <typename R>
+	void face_code(mesh::faceidx_t f, R &&res)
 	{
 		mesh::regidx_t r = mesh.attrs.face2reg(f);
 
-		AbsAttrCoder::face(f, le);
-		wr.reg_face(r);
+		if (only == ALL) wr.reg_face(r);
 
 		for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_face_reg(r); ++a) {
 			mesh::listidx_t l = mesh.attrs.binding_reg_facelist(r, a);
+			if (!codes(l)) continue;
 			mesh::attridx_t idx = mesh.attrs.binding_face_attr(f, a);
 
 			mesh::attridx_t tidx = ghist[l].lget_set(idx);
@@ -359,19 +413,17 @@ struct AttrCoder : AbsAttrCoder {
 				continue;
 			}
 
-			mixing::View res = mesh.attrs[l].accu()[0];
-			res.setq([] (int q, const auto raw, const auto pred) { return pred::encodeDelta(raw, pred, q); }, mesh.attrs[l][idx], res);
-			wr.attr_data(res, l);
+			wr.attr_data(res(a, l, idx), l);
 		}
 	}
-	void corner_post(mesh::faceidx_t f, mesh::ledgeidx_t le)
+	template <typename R>
+	void corner_code(mesh::faceidx_t f, mesh::ledgeidx_t le, R &&res)
 	{
 		mesh::regidx_t r = mesh.attrs.face2reg(f);
 
-		AbsAttrCoder::corner(f, le);
-
 		for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_corner_reg(r); ++a) {
 			mesh::listidx_t l = mesh.attrs.binding_reg_cornerlist(r, a);
+			if (!codes(l)) continue;
 			mesh::attridx_t idx = mesh.attrs.binding_corner_attr(f, le, a);
 
 			mesh::attridx_t lidx = lhist[a].insert(mesh.conn.org(f, le), idx);
@@ -386,24 +438,65 @@ struct AttrCoder : AbsAttrCoder {
 				continue;
 			}
 
-			mixing::View res = mesh.attrs[l].accu()[0];
-			res.setq([] (int q, const auto raw, const auto pred) { return pred::encodeDelta(raw, pred, q); }, mesh.attrs[l][idx], res);
-			wr.attr_data(res, l);
+			wr.attr_data(res(a, l, idx), l);
 		}
 	}
 
+	void vtx_post(mesh::faceidx_t f, mesh::ledgeidx_t le)
+	{
+		AbsAttrCoder::vtx(f, le);
+		vtx_code(mesh::conn::fepair(f, le), [this] (mesh::listidx_t, mesh::listidx_t l, mesh::attridx_t idx) {
+			residual(*this, l, idx, accu(l)[0]);
+			return accu(l)[0];
+		});
+	}
+	void face_post(mesh::faceidx_t f, mesh::ledgeidx_t le)
+	{
+		AbsAttrCoder::face(f, le);
+		face_code(f, [this] (mesh::listidx_t, mesh::listidx_t l, mesh::attridx_t idx) {
+			residual(*this, l, idx, accu(l)[0]);
+			return accu(l)[0];
+		});
+	}
+	void corner_post(mesh::faceidx_t f, mesh::ledgeidx_t le)
+	{
+		AbsAttrCoder::corner(f, le);
+		corner_code(f, le, [this] (mesh::listidx_t, mesh::listidx_t l, mesh::attridx_t idx) {
+			residual(*this, l, idx, accu(l)[0]);
+			return accu(l)[0];
+		});
+	}
+
+	// Regions of all vertices and faces, which are coded with the connectivity when the lists have their own streams
+	void encode_regions()
+	{
+		for (mesh::conn::fepair e : order) wr.reg_vtx(mesh.attrs.vtx2reg(mesh.conn.org(e)));
+		for (mesh::conn::fepair e : order_f) wr.reg_face(mesh.attrs.face2reg(e.f()));
+	}
+
 	template <typename P>
-	void encode(P &prog)
+	void encode(P &prog, threads::Pool *pool = nullptr)
 	{
+		encode(prog, order, order_f, pool);
+	}
+	// Codes the selected lists in the traversal order of another coder; with a pool the residuals are computed in parallel
+	template <typename P>
+	void encode(P &prog, const std::vector<mesh::conn::fepair> &order, const std::vector<mesh::conn::fepair> &order_f, threads::Pool *pool = nullptr)
+	{
+		if (pool && pool->size() > 1) {
+			encode_parallel(prog, order, order_f, *pool);
+			return;
+		}
+		bool vtxs = codes_target(mesh::attr::VTX), faces = codes_target(mesh::attr::FACE) || codes_target(mesh::attr::CORNER);
 		prog.start(order.size());
-		for (int i = 0; i < order.size(); ++i) {
-			mesh::conn::fepair &e = order[i];
+		for (int i = 0; vtxs && i < order.size(); ++i) {
+			const mesh::conn::fepair &e = order[i];
 
 			vtx_post(e.f(), e.e());
 			prog(i);
 		}
-		for (int i = 0; i < order_f.size(); ++i) {
-			mesh::conn::fepair &e = order_f[i];
+		for (int i = 0; faces && i < order_f.size(); ++i) {
+			const mesh::conn::fepair &e = order_f[i];
 			face_post(e.f(), e.e());
 			int ne = mesh.conn.num_edges(e.f()), c = e.e();
 			do {
@@ -414,6 +507,105 @@ struct AttrCoder : AbsAttrCoder {
 		}
 		prog.end();
 	}
+
+	// The order is coded in blocks: first the residuals of a block are computed in parallel, then they are entropy coded in order.
+	// Predictions only depend on which elements come earlier in the order, so every worker has its own coded flags and scratch
+	// and advances the flags to the start of its range; the output is the same as the one of the sequential encode.
+	template <typename P>
+	void encode_parallel(P &prog, const std::vector<mesh::conn::fepair> &order, const std::vector<mesh::conn::fepair> &order_f, threads::Pool &pool)
+	{
+		static const std::size_t BLOCK = 1 << 16;
+		bool vtxs = codes_target(mesh::attr::VTX), faces = codes_target(mesh::attr::FACE) || codes_target(mesh::attr::CORNER);
+		std::size_t num = pool.size();
+		std::vector<AbsAttrCoder> workers(num, AbsAttrCoder(mesh, only));
+		std::vector<std::size_t> cur(num, 0); // position up to which the flags of a worker are set
+
+		// residuals of the current block, per list with one slot per binding of each element
+		std::vector<mixing::Array> res;
+		for (mesh::listidx_t l = 0; l < mesh.attrs.size(); ++l) res.emplace_back(mesh.attrs[l].fmt());
+		auto resize = [&] (mesh::attr::Target t, std::size_t size) {
+			for (mesh::listidx_t l = 0; l < mesh.attrs.size(); ++l) {
+				if (codes(l) && mesh.attrs[l].target == t) res[l].resize(size);
+			}
+		};
+
+		prog.start(order.size());
+		mesh::listidx_t nbv = mesh.attrs.num_bindings_vtx;
+		for (std::size_t b = 0; vtxs && b < order.size(); b += BLOCK) {
+			std::size_t e = std::min(order.size(), b + BLOCK);
+			resize(mesh::attr::VTX, (e - b) * nbv);
+			pool.run(num, [&] (std::size_t k) {
+				AbsAttrCoder &w = workers[k];
+				std::size_t lo = b + (e - b) * k / num, hi = b + (e - b) * (k + 1) / num;
+				for (; cur[k] < lo; ++cur[k]) w.vtx_is_encoded[mesh.conn.org(order[cur[k]])] = true;
+				for (std::size_t i = lo; i < hi; ++i) {
+					mesh::vtxidx_t v = mesh.conn.org(order[i]);
+					mesh::regidx_t r = mesh.attrs.vtx2reg(v);
+					w.vtx(order[i].f(), order[i].e());
+					for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_vtx_reg(r); ++a) {
+						mesh::listidx_t l = mesh.attrs.binding_reg_vtxlist(r, a);
+						if (codes(l)) residual(w, l, mesh.attrs.binding_vtx_attr(v, a), res[l][(i - b) * nbv + a]);
+					}
+				}
+				cur[k] = hi;
+			});
+			for (std::size_t i = b; i < e; ++i) {
+				vtx_code(order[i], [&] (mesh::listidx_t a, mesh::listidx_t l, mesh::attridx_t) { return res[l][(i - b) * nbv + a]; });
+				prog(i);
+			}
+		}
+
+		cur.assign(num, 0);
+		mesh::listidx_t nbf = mesh.attrs.num_bindings_face, nbc = mesh.attrs.num_bindings_corner;
+		std::vector<std::size_t> coff; // first corner of each face of the block
+		for (std::size_t b = 0; faces && b < order_f.size(); b += BLOCK) {
+			std::size_t e = std::min(order_f.size(), b + BLOCK);
+			coff.assign(1, 0);
+			for (std::size_t j = b; j < e; ++j) coff.push_back(coff.back() + mesh.conn.num_edges(order_f[j].f()));
+			resize(mesh::attr::FACE, (e - b) * nbf);
+			resize(mesh::attr::CORNER, coff.back() * nbc);
+			pool.run(num, [&] (std::size_t k) {
+				AbsAttrCoder &w = workers[k];
+				std::size_t lo = b + (e - b) * k / num, hi = b + (e - b) * (k + 1) / num;
+				for (; cur[k] < lo; ++cur[k]) w.face_is_encoded[order_f[cur[k]].f()] = true;
+				for (std::size_t j = lo; j < hi; ++j) {
+					mesh::faceidx_t f = order_f[j].f();
+					mesh::regidx_t r = mesh.attrs.face2reg(f);
+					w.face(f, order_f[j].e());
+					for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_face_reg(r); ++a) {
+						mesh::listidx_t l = mesh.attrs.binding_reg_facelist(r, a);
+						if (codes(l)) residual(w, l, mesh.attrs.binding_face_attr(f, a), res[l][(j - b) * nbf + a]);
+					}
+					int ne = mesh.conn.num_edges(f), c = order_f[j].e();
+					std::size_t oc = coff[j - b];
+					do {
+						w.corner(f, c);
+						for (mesh::listidx_t a = 0; a < mesh.attrs.num_bindings_corner_reg(r); ++a) {
+							mesh::listidx_t l = mesh.attrs.binding_reg_cornerlist(r, a);
+							if (codes(l)) residual(w, l, mesh.attrs.binding_corner_attr(f, c, a), res[l][oc * nbc + a]);
+						}
+						++oc;
+						++c;
+						if (c == ne) c = 0;
+					} while (c != order_f[j].e());
+				}
+				cur[k] = hi;
+			});
+			for (std::size_t j = b; j < e; ++j) {
+				mesh::faceidx_t f = order_f[j].f();
+				face_code(f, [&] (mesh::listidx_t a, mesh::listidx_t l, mesh::attridx_t) { return res[l][(j - b) * nbf + a]; });
+				int ne = mesh.conn.num_edges(f), c = order_f[j].e();
+				std::size_t oc = coff[j - b];
+				do {
+					corner_code(f, c, [&] (mesh::listidx_t a, mesh::listidx_t l, mesh::attridx_t) { return res[l][oc * nbc + a]; });
+					++oc;
+					++c;
+					if (c == ne) c = 0;
+				} while (c != order_f[j].e());
+			}
+		}
+		prog.end();
+	}
 };
 
 
@@ -427,10 +619,13 @@ struct AttrDecoder : AbsAttrCoder {
 	mesh::Builder &builder;
 	std::vector<mesh::conn::fepair> order;
 	
-	AttrDecoder(mesh::Builder &_builder, RD &_rd) : builder(_builder), rd(_rd), AbsAttrCoder(_builder.mesh), lhist(mesh.attrs.num_bindings_corner), cur_idx(_builder.mesh.attrs.size(), 0)
+	AttrDecoder(mesh::Builder &_builder, RD &_rd, mesh::listidx_t _only = ALL) : builder(_builder), rd(_rd), AbsAttrCoder(_builder.mesh, _only), cur_idx(_builder.mesh.attrs.size(), 0)
 	{
-		for (mesh::listidx_t i = 0; i < mesh.attrs.num_bindings_corner; ++i) {
-			lhist[i].resize(mesh.attrs.num_vtx());
+		if (codes_target(mesh::attr::CORNER)) {
+			lhist.resize(mesh.attrs.num_bindings_corner);
+			for (mesh::listidx_t i = 0; i < mesh.attrs.num_bindings_corner; ++i) {
+				lhist[i].resize(mesh.attrs.num_vtx());
+			}
 		}
 	}
 
@@ -444,13 +639,14 @@ struct AttrDecoder : AbsAttrCoder {
 	{
 		mesh::conn::fepair e(f, le);
 		mesh::vtxidx_t v = builder.mesh.conn.org(e);
-		mesh::regidx_t r = rd.reg_vtx();
-		builder.vtx_reg(v, r);
+		if (only == ALL) builder.vtx_reg(v, rd.reg_vtx());
+		mesh::regidx_t r = mesh.attrs.vtx2reg(v);
 
 		AbsAttrCoder::vtx(f, le);
 
 		for (mesh::listidx_t a = 0; a < builder.mesh.attrs.num_bindings_vtx_reg(r); ++a) {
 			mesh::listidx_t l = builder.mesh.attrs.binding_reg_vtxlist(r, a);
+			if (!codes(l)) continue;
 			mesh::attridx_t idx;
 
 			switch (rd.attr_type(l)) {
@@ -458,7 +654,7 @@ struct AttrDecoder : AbsAttrCoder {
 				idx = cur_idx[l]++;
 				rd.attr_data(builder.mesh.attrs[l][idx], l);
 
-				mesh.attrs[l][idx].setq([] (int q, const auto delta, const auto pred) { return pred::decodeDelta(delta, pred, q); }, mesh.attrs[l][idx], mesh.attrs[l].accu()[0]);
+				mesh.attrs[l][idx].setq([] (int q, const auto delta, const auto pred) { return pred::decodeDelta(delta, pred, q); }, mesh.attrs[l][idx], accu(l)[0]);
 				break;
 			case HIST:
 				idx = cur_idx[l] - 1 - rd.attr_ghist(l);
@@ -475,13 +671,14 @@ struct AttrDecoder : AbsAttrCoder {
 	}
 	void face_post(mesh::faceidx_t f, mesh::ledgeidx_t le)
 	{
-		mesh::regidx_t r = rd.reg_face();
-		builder.face_reg(f, r);
+		if (only == ALL) builder.face_reg(f, rd.reg_face());
+		mesh::regidx_t r = mesh.attrs.face2reg(f);
 
 		AbsAttrCoder::face(f, le);
 
 		for (mesh::listidx_t a = 0; a < builder.mesh.attrs.num_bindings_face_reg(r); ++a) {
 			mesh::listidx_t l = builder.mesh.attrs.binding_reg_facelist(r, a);
+			if (!codes(l)) continue;
 			mesh::attridx_t idx;
 
 			switch (rd.attr_type(l)) {
@@ -489,7 +686,7 @@ struct AttrDecoder : AbsAttrCoder {
 				idx = cur_idx[l]++;
 				rd.attr_data(builder.mesh.attrs[l][idx], l);
 
-				mesh.attrs[l][idx].setq([] (int q, const auto delta, const auto pred) { return pred::decodeDelta(delta, pred, q); }, mesh.attrs[l][idx], mesh.attrs[l].accu()[0]);
+				mesh.attrs[l][idx].setq([] (int q, const auto delta, const auto pred) { return pred::decodeDelta(delta, pred, q); }, mesh.attrs[l][idx], accu(l)[0]);
 				break;
 			case HIST:
 				idx = cur_idx[l] - 1 - rd.attr_ghist(l);
@@ -507,6 +704,7 @@ struct AttrDecoder : AbsAttrCoder {
 
 		for (mesh::listidx_t a = 0; a < builder.mesh.attrs.num_bindings_corner_reg(r); ++a) {
 			mesh::listidx_t l = builder.mesh.attrs.binding_reg_cornerlist(r, a);
+			if (!codes(l)) continue;
 			mesh::attridx_t idx;
 
 			switch (rd.attr_type(l)) {
@@ -514,7 +712,7 @@ struct AttrDecoder : AbsAttrCoder {
 				idx = cur_idx[l]++;
 				rd.attr_data(builder.mesh.attrs[l][idx], l);
 
-				mesh.attrs[l][idx].setq([] (int q, const auto delta, const auto pred) { return pred::decodeDelta(delta, pred, q); }, mesh.attrs[l][idx], mesh.attrs[l].accu()[0]);
+				mesh.attrs[l][idx].setq([] (int q, const auto delta, const auto pred) { return pred::decodeDelta(delta, pred, q); }, mesh.attrs[l][idx], accu(l)[0]);
 				lhist[a].insert(mesh.conn.org(f, le), idx);
 				break;
 			case HIST:
@@ -530,17 +728,30 @@ struct AttrDecoder : AbsAttrCoder {
 		}
 	}
 
+	// Counterpart of AttrCoder::encode_regions
+	void decode_regions()
+	{
+		for (mesh::conn::fepair e : order) builder.vtx_reg(builder.mesh.conn.org(e), rd.reg_vtx());
+		for (mesh::faceidx_t f = 0; f < builder.mesh.attrs.num_face(); ++f) builder.face_reg(f, rd.reg_face());
+	}
+
 	template <typename P>
 	void decode(P &prog)
 	{
+		decode(prog, order);
+	}
+	template <typename P>
+	void decode(P &prog, const std::vector<mesh::conn::fepair> &order)
+	{
+		bool vtxs = codes_target(mesh::attr::VTX), faces = codes_target(mesh::attr::FACE) || codes_target(mesh::attr::CORNER);
 		prog.start(order.size());
-		for (int i = 0; i < order.size(); ++i) {
-			mesh::conn::fepair &e = order[i];
+		for (int i = 0; vtxs && i < order.size(); ++i) {
+			const mesh::conn::fepair &e = order[i];
 
 			vtx_post(e.f(), e.e());
 			prog(i);
 		}
-		for (int i = 0; i < builder.mesh.attrs.num_face(); ++i) {
+		for (int i = 0; faces && i < builder.mesh.attrs.num_face(); ++i) {
 			face_post(i, 0);
 			for (int c = 0; c < mesh.conn.num_edges(i); ++c) {
 				corner_post(i, c);
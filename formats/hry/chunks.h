@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Chunked container: the mesh is split into chunks of faces, which are coded as independent meshes with their own
+ * models and coder streams. Vertices on the boundary between chunks are coded in every chunk they belong to;
+ * the chunk table lists them, so the decoder can stitch the chunks back together.
+ */
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+
+#include "structs/mesh.h"
+
+namespace hry {
+namespace chunks {
+
+static const uint32_t UNSET = std::numeric_limits<uint32_t>::max();
+
+struct Chunk {
+	uint32_t nv, nf, ne;
+	std::vector<uint32_t> sizes; // number of attributes per list
+	std::vector<std::pair<uint32_t, uint32_t>> shared; // decoded vertex of the chunk, vertex of an earlier chunk in the output
+	std::string data; // static tables and coded stream
+};
+
+// Grows chunks of at most budget faces along the face adjacency; small components are packed into the same chunk
+inline std::vector<std::vector<mesh::faceidx_t>> partition(mesh::Mesh &mesh, mesh::faceidx_t budget)
+{
+	std::vector<std::vector<mesh::faceidx_t>> res;
+	std::vector<bool> visited(mesh.num_face(), false);
+	std::deque<mesh::faceidx_t> queue;
+
+	res.emplace_back();
+	for (mesh::faceidx_t seed = 0; seed < mesh.num_face(); ++seed) {
+		if (visited[seed]) continue;
+		visited[seed] = true;
+		queue.push_back(seed);
+		while (!queue.empty()) {
+			mesh::faceidx_t f = queue.front();
+			queue.pop_front();
+			if (res.back().size() == budget) res.emplace_back();
+			res.back().push_back(f);
+
+			for (mesh::ledgeidx_t e = 0; e < mesh.conn.num_edges(f); ++e) {
+				mesh::conn::fepair t = mesh.conn.twin(mesh::conn::fepair(f, e));
+				if (visited[t.f()]) continue;
+				visited[t.f()] = true;
+				queue.push_back(t.f());
+			}
+		}
+	}
+	if (res.back().empty()) res.pop_back();
+	return res;
+}
+
+// Copies everything but the elements: attribute lists with their formats and bounds, regions and bindings
+inline void copy_syntax(mesh::Mesh &src, mesh::Mesh &dst)
+{
+	mesh::Builder builder(dst);
+	mesh::attr::Attrs &attrs = src.attrs;
+	for (mesh::regidx_t r = 0; r < attrs.num_regs_face(); ++r) {
+		builder.add_face_region(attrs.num_bindings_face_reg(r), attrs.num_bindings_corner_reg(r));
+		for (mesh::listidx_t a = 0; a < attrs.num_bindings_face_reg(r); ++a) builder.bind_reg_facelist(r, a, attrs.binding_reg_facelist(r, a));
+		for (mesh::listidx_t a = 0; a < attrs.num_bindings_corner_reg(r); ++a) builder.bind_reg_cornerlist(r, a, attrs.binding_reg_cornerlist(r, a));
+	}
+	for (mesh::regidx_t r = 0; r < attrs.num_regs_vtx(); ++r) {
+		builder.add_vtx_region(attrs.num_bindings_vtx_reg(r));
+		for (mesh::listidx_t a = 0; a < attrs.num_bindings_vtx_reg(r); ++a) builder.bind_reg_vtxlist(r, a, attrs.binding_reg_vtxlist(r, a));
+	}
+	builder.init_bindings(attrs.num_bindings_face, attrs.num_bindings_vtx, attrs.num_bindings_corner);
+
+	for (mesh::listidx_t l = 0; l < attrs.size(); ++l) {
+		mesh::listidx_t dl = builder.add_list(attrs[l].fmt(), attrs[l].interps(), attrs[l].target);
+		std::memcpy(dst.attrs[dl].bounds().data(), attrs[l].bounds().data(), attrs[l].bounds().bytes());
+	}
+	dst.faces.have_edges = src.faces.have_edges;
+}
+
+// Builds the mesh of a chunk; verts maps its vertices to the vertices of src
+inline void extract(mesh::Mesh &src, const std::vector<mesh::faceidx_t> &faces, mesh::Mesh &dst, std::vector<mesh::vtxidx_t> &verts)
+{
+	mesh::attr::Attrs &attrs = src.attrs;
+	copy_syntax(src, dst);
+	mesh::Builder builder(dst);
+
+	// local indices of faces, vertices and attributes are their ranks among the referenced ones
+	std::vector<std::pair<mesh::faceidx_t, mesh::faceidx_t>> lfaces;
+	std::vector<std::vector<mesh::attridx_t>> lattrs(attrs.size());
+	mesh::edgeidx_t ne = 0;
+	for (mesh::faceidx_t i = 0; i < faces.size(); ++i) {
+		mesh::faceidx_t f = faces[i];
+		lfaces.emplace_back(f, i);
+		ne += src.conn.num_edges(f);
+		mesh::regidx_t r = attrs.face2reg(f);
+		for (mesh::listidx_t a = 0; a < attrs.num_bindings_face_reg(r); ++a) lattrs[attrs.binding_reg_facelist(r, a)].push_back(attrs.binding_face_attr(f, a));
+		for (mesh::ledgeidx_t c = 0; c < src.conn.num_edges(f); ++c) {
+			verts.push_back(src.conn.org(f, c));
+			for (mesh::listidx_t a = 0; a < attrs.num_bindings_corner_reg(r); ++a) lattrs[attrs.binding_reg_cornerlist(r, a)].push_back(attrs.binding_corner_attr(f, c, a));
+		}
+	}
+	std::sort(lfaces.begin(), lfaces.end());
+	std::sort(verts.begin(), verts.end());
+	verts.erase(std::unique(verts.begin(), verts.end()), verts.end());
+	for (mesh::vtxidx_t v : verts) {
+		mesh::regidx_t r = attrs.vtx2reg(v);
+		for (mesh::listidx_t a = 0; a < attrs.num_bindings_vtx_reg(r); ++a) lattrs[attrs.binding_reg_vtxlist(r, a)].push_back(attrs.binding_vtx_attr(v, a));
+	}
+	for (std::vector<mesh::attridx_t> &la : lattrs) {
+		std::sort(la.begin(), la.end());
+		la.erase(std::unique(la.begin(), la.end()), la.end());
+	}
+	auto lvtx = [&verts] (mesh::vtxidx_t v) { return (mesh::vtxidx_t)(std::lower_bound(verts.begin(), verts.end(), v) - verts.begin()); };
+	auto lattr = [&lattrs] (mesh::listidx_t l, mesh::attridx_t i) { return (mesh::attridx_t)(std::lower_bound(lattrs[l].begin(), lattrs[l].end(), i) - lattrs[l].begin()); };
+
+	builder.alloc_vtx(verts.size());
+	builder.alloc_face(faces.size(), ne);
+	for (mesh::listidx_t l = 0; l < attrs.size(); ++l) {
+		builder.alloc_attr(l, lattrs[l].size());
+		std::size_t bytes = attrs[l].fmt().bytes();
+		for (mesh::attridx_t i = 0; i < lattrs[l].size(); ++i) {
+			std::memcpy(dst.attrs[l][i].data(), attrs[l][lattrs[l][i]].data(), bytes);
+		}
+	}
+
+	for (mesh::vtxidx_t v = 0; v < verts.size(); ++v) {
+		mesh::regidx_t r = attrs.vtx2reg(verts[v]);
+		builder.vtx_reg(v, r);
+		for (mesh::listidx_t a = 0; a < attrs.num_bindings_vtx_reg(r); ++a) builder.bind_vtx_attr(v, a, lattr(attrs.binding_reg_vtxlist(r, a), attrs.binding_vtx_attr(verts[v], a)));
+	}
+	for (mesh::faceidx_t i = 0; i < faces.size(); ++i) {
+		mesh::faceidx_t f = faces[i];
+		mesh::regidx_t r = attrs.face2reg(f);
+		dst.conn.add_face(src.conn.num_edges(f));
+		builder.face_reg(i, r);
+		for (mesh::listidx_t a = 0; a < attrs.num_bindings_face_reg(r); ++a) builder.bind_face_attr(i, a, lattr(attrs.binding_reg_facelist(r, a), attrs.binding_face_attr(f, a)));
+		for (mesh::ledgeidx_t c = 0; c < src.conn.num_edges(f); ++c) {
+			dst.conn.set_org(i, c, lvtx(src.conn.org(f, c)));
+			for (mesh::listidx_t a = 0; a < attrs.num_bindings_corner_reg(r); ++a) builder.bind_corner_attr(i, c, a, lattr(attrs.binding_reg_cornerlist(r, a), attrs.binding_corner_attr(f, c, a)));
+		}
+	}
+
+	// edges to other chunks become borders
+	for (mesh::faceidx_t i = 0; i < faces.size(); ++i) {
+		for (mesh::ledgeidx_t c = 0; c < src.conn.num_edges(faces[i]); ++c) {
+			mesh::conn::fepair t = src.conn.twin(mesh::conn::fepair(faces[i], c));
+			std::vector<std::pair<mesh::faceidx_t, mesh::faceidx_t>>::iterator it = std::lower_bound(lfaces.begin(), lfaces.end(), std::make_pair(t.f(), (mesh::faceidx_t)0));
+			if (it == lfaces.end() || it->first != t.f()) continue;
+			dst.conn.fmerge(mesh::conn::fepair(i, c), mesh::conn::fepair(it->second, t.e()));
+		}
+	}
+}
+
+// Assigns output vertices to the decoded vertices of all chunks, in chunk order; vorders holds the vertices of src in decoding order
+inline mesh::vtxidx_t stitch(mesh::vtxidx_t nv, const std::vector<std::vector<mesh::vtxidx_t>> &vorders, std::vector<Chunk> &table)
+{
+	std::vector<mesh::vtxidx_t> out(nv, UNSET);
+	mesh::vtxidx_t next = 0;
+	for (std::size_t c = 0; c < table.size(); ++c) {
+		for (mesh::vtxidx_t i = 0; i < vorders[c].size(); ++i) {
+			mesh::vtxidx_t &o = out[vorders[c][i]];
+			if (o == UNSET) o = next++;
+			else table[c].shared.emplace_back(i, o);
+		}
+	}
+	return next;
+}
+
+// Appends the decoded chunks to the mesh, which holds the syntax and the allocated vertices and faces
+inline void merge(mesh::Builder &builder, std::vector<mesh::Mesh*> &meshes, const std::vector<Chunk> &table)
+{
+	mesh::Mesh &out = builder.mesh;
+	mesh::attr::Attrs &attrs = out.attrs;
+	for (mesh::listidx_t l = 0; l < attrs.size(); ++l) attrs[l].resize(0);
+
+	std::vector<bool> is_shared(out.num_vtx(), false);
+	mesh::vtxidx_t next = 0;
+	for (std::size_t c = 0; c < meshes.size(); ++c) {
+		mesh::Mesh &sub = *meshes[c];
+		mesh::attr::Attrs &sattrs = sub.attrs;
+
+		std::vector<mesh::attridx_t> off(attrs.size());
+		for (mesh::listidx_t l = 0; l < attrs.size(); ++l) {
+			off[l] = attrs[l].size();
+			attrs[l].resize(off[l] + sattrs[l].size());
+			std::memcpy(attrs[l][off[l]].data(), sattrs[l].data(), sattrs[l].bytes());
+		}
+
+		std::vector<mesh::vtxidx_t> vm(sub.num_vtx(), UNSET);
+		for (const std::pair<uint32_t, uint32_t> &s : table[c].shared) {
+			if (s.first >= vm.size() || s.second >= next) throw std::runtime_error("Corrupt chunk table");
+			vm[s.first] = s.second;
+			is_shared[s.second] = true;
+		}
+		for (mesh::vtxidx_t v = 0; v < sub.num_vtx(); ++v) {
+			if (vm[v] != UNSET) continue;
+			if (next == out.num_vtx()) throw std::runtime_error("Corrupt chunk table");
+			vm[v] = next++;
+			mesh::regidx_t r = sattrs.vtx2reg(v);
+			builder.vtx_reg(vm[v], r);
+			for (mesh::listidx_t a = 0; a < sattrs.num_bindings_vtx_reg(r); ++a) builder.bind_vtx_attr(vm[v], a, sattrs.binding_vtx_attr(v, a) + off[sattrs.binding_reg_vtxlist(r, a)]);
+		}
+
+		mesh::faceidx_t foff = out.conn.num_face();
+		for (mesh::faceidx_t f = 0; f < sub.num_face(); ++f) {
+			mesh::faceidx_t of = out.conn.add_face(sub.conn.num_edges(f));
+			mesh::regidx_t r = sattrs.face2reg(f);
+			builder.face_reg(of, r);
+			for (mesh::listidx_t a = 0; a < sattrs.num_bindings_face_reg(r); ++a) builder.bind_face_attr(of, a, sattrs.binding_face_attr(f, a) + off[sattrs.binding_reg_facelist(r, a)]);
+			for (mesh::ledgeidx_t e = 0; e < sub.conn.num_edges(f); ++e) {
+				out.conn.set_org(of, e, vm[sub.conn.org(f, e)]);
+				for (mesh::listidx_t a = 0; a < sattrs.num_bindings_corner_reg(r); ++a) builder.bind_corner_attr(of, e, a, sattrs.binding_corner_attr(f, e, a) + off[sattrs.binding_reg_cornerlist(r, a)]);
+			}
+		}
+		for (mesh::faceidx_t f = 0; f < sub.num_face(); ++f) {
+			for (mesh::ledgeidx_t e = 0; e < sub.conn.num_edges(f); ++e) {
+				mesh::conn::fepair t = sub.conn.twin(mesh::conn::fepair(f, e));
+				out.conn.fmerge(mesh::conn::fepair(foff + f, e), mesh::conn::fepair(foff + t.f(), t.e()));
+			}
+		}
+
+		delete meshes[c]; // keeps the peak memory low
+		meshes[c] = nullptr;
+	}
+
+	// merge the borders between chunks again
+	std::unordered_map<uint64_t, mesh::conn::fepair> open;
+	for (mesh::faceidx_t f = 0; f < out.num_face(); ++f) {
+		for (mesh::ledgeidx_t e = 0; e < out.conn.num_edges(f); ++e) {
+			mesh::conn::fepair a(f, e);
+			mesh::vtxidx_t v0 = out.conn.org(a), v1 = out.conn.dest(a);
+			if (out.conn.twin(a) != a || !is_shared[v0] || !is_shared[v1]) continue;
+			std::unordered_map<uint64_t, mesh::conn::fepair>::iterator it = open.find((uint64_t)v1 << 32 | v0);
+			if (it != open.end()) {
+				out.conn.fmerge(a, it->second);
+				open.erase(it);
+			} else {
+				open.emplace((uint64_t)v0 << 32 | v1, a);
+			}
+		}
+	}
+
+	// drop the attributes, which were only referenced by the copies of boundary vertices
+	std::vector<std::vector<mesh::attridx_t>> remap(attrs.size());
+	for (mesh::listidx_t l = 0; l < attrs.size(); ++l) remap[l].assign(attrs[l].size(), UNSET);
+	auto mark = [&remap] (mesh::listidx_t l, mesh::attridx_t i) { remap[l][i] = 0; };
+	for (mesh::vtxidx_t v = 0; v < out.num_vtx(); ++v) {
+		mesh::regidx_t r = attrs.vtx2reg(v);
+		for (mesh::listidx_t a = 0; a < attrs.num_bindings_vtx_reg(r); ++a) mark(attrs.binding_reg_vtxlist(r, a), attrs.binding_vtx_attr(v, a));
+	}
+	for (mesh::listidx_t l = 0; l < attrs.size(); ++l) {
+		if (attrs[l].target != mesh::attr::VTX) continue;
+		std::size_t bytes = attrs[l].fmt().bytes();
+		mesh::attridx_t n = 0;
+		for (mesh::attridx_t i = 0; i < attrs[l].size(); ++i) {
+			if (remap[l][i] == UNSET) continue;
+			if (n != i) std::memmove(attrs[l][n].data(), attrs[l][i].data(), bytes);
+			remap[l][i] = n++;
+		}
+		attrs[l].resize(n);
+	}
+	for (mesh::vtxidx_t v = 0; v < out.num_vtx(); ++v) {
+		mesh::regidx_t r = attrs.vtx2reg(v);
+		for (mesh::listidx_t a = 0; a < attrs.num_bindings_vtx_reg(r); ++a) {
+			mesh::attridx_t &b = attrs.binding_vtx_attr(v, a);
+			b = remap[attrs.binding_reg_vtxlist(r, a)][b];
+		}
+	}
+}
+
+}
+}
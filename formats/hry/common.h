@@ -13,6 +13,21 @@ namespace hry {
 
 // Format version
 static const int VER_MAJ = 0;
-static const int VER_MIN = 1;
+static const int VER_MIN = 4;
+
+// Entropy coder backends, stored in the header
+enum Backend { ARITH, RANGE, RANS };
+
+// Header flags
+enum Flags {
+	POW2 = 1,   // multi-symbol models keep their totals at a power of two
+	STATIC = 2, // multi-symbol models use static tables, which precede the coded data
+	CHUNKED = 4, // the mesh is coded in independent chunks, which are listed in a chunk table (see chunks.h)
+	STREAMS = 8, // connectivity and each attribute list are coded into separate streams, which are listed in a stream directory
+	LOG = 16     // the data is an uncoded symbol log (see ir.h), which has to be re-coded before it can be decoded
+};
+
+// Models for the bytes of attribute residuals, stored per list in the header
+enum AttrModel { MULT, BINARY };
 
 }
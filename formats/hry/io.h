@@ -16,23 +16,13 @@
 namespace hry {
 namespace io {
 
-struct writer {
-	HryModels &models;
-	arith::Encoder<> &coder;
-
-	writer(HryModels &_models, arith::Encoder<> &_coder) : models(_models), coder(_coder)
-	{}
-
-	void order(int i)
-	{
-		models.order(i);
-	}
-
-	// Connectivity
+// Connectivity symbols of the cut-border machine, coded with the primitives (iop, op, elem, part, vertid, numtri) of D
+template <typename D>
+struct conn_writer {
 	void initial(int ntri)
 	{
-		iop(cbm::INIT);
-		numtri(ntri);
+		d().iop(cbm::INIT);
+		d().numtri(ntri);
 	}
 	void tri100(int ntri, mesh::vtxidx_t v0) { tri1(ntri, v0, cbm::TRI100); }
 	void tri010(int ntri, mesh::vtxidx_t v0) { tri1(ntri, v0, cbm::TRI010); }
@@ -46,44 +36,86 @@ struct writer {
 
 	void end()
 	{
-		iop(cbm::EOM);
+		d().iop(cbm::EOM);
 	}
 	void border(cbm::OP bop = cbm::BORDER)
 	{
-		op(bop);
+		d().op(bop);
 	}
 	void newvertex(int ntri)
 	{
-		op(cbm::NEWVTX);
-		numtri(ntri);
+		d().op(cbm::NEWVTX);
+		d().numtri(ntri);
 	}
 	void connectforward(int ntri)
 	{
-		op(cbm::CONNFWD);
-		numtri(ntri);
+		d().op(cbm::CONNFWD);
+		d().numtri(ntri);
 	}
 	void connectbackward(int ntri)
 	{
-		op(cbm::CONNBWD);
-		numtri(ntri);
+		d().op(cbm::CONNBWD);
+		d().numtri(ntri);
 	}
 	void splitcutborder(int ntri, int i)
 	{
-		op(cbm::SPLIT);
-		elem(i);
-		numtri(ntri);
+		d().op(cbm::SPLIT);
+		d().elem(i);
+		d().numtri(ntri);
 	}
 	void cutborderunion(int ntri, int i, int p)
 	{
-		op(cbm::UNION);
-		elem(i); part(p);
-		numtri(ntri);
+		d().op(cbm::UNION);
+		d().elem(i); d().part(p);
+		d().numtri(ntri);
 	}
 	void nm(int ntri, mesh::vtxidx_t idx)
 	{
-		op(cbm::NM);
-		vertid(idx);
-		numtri(ntri);
+		d().op(cbm::NM);
+		d().vertid(idx);
+		d().numtri(ntri);
+	}
+
+private:
+	D &d()
+	{
+		return static_cast<D&>(*this);
+	}
+
+	void tri1(int ntri, mesh::vtxidx_t v0, cbm::INITOP op)
+	{
+		d().iop(op);
+		d().vertid(v0);
+		d().numtri(ntri);
+	}
+	void tri2(int ntri, mesh::vtxidx_t v0, mesh::vtxidx_t v1, cbm::INITOP op)
+	{
+		d().iop(op);
+		d().vertid(v0);
+		d().vertid(v1);
+		d().numtri(ntri);
+	}
+	void tri3(int ntri, mesh::vtxidx_t v0, mesh::vtxidx_t v1, mesh::vtxidx_t v2, cbm::INITOP op)
+	{
+		d().iop(op);
+		d().vertid(v0);
+		d().vertid(v1);
+		d().vertid(v2);
+		d().numtri(ntri);
+	}
+};
+
+template <typename C = ArithCoders>
+struct writer : conn_writer<writer<C>> {
+	HryModels<C> &models;
+	typename C::Encoder &coder;
+
+	writer(HryModels<C> &_models, typename C::Encoder &_coder) : models(_models), coder(_coder)
+	{}
+
+	void order(int i)
+	{
+		models.order(i);
 	}
 
 	// Attributes
@@ -115,29 +147,7 @@ struct writer {
 		models.conn_regvtx.template encode<uint16_t>(coder, r);
 	}
 
-private:
-	void tri1(int ntri, mesh::vtxidx_t v0, cbm::INITOP op)
-	{
-		iop(op);
-		vertid(v0);
-		numtri(ntri);
-	}
-	void tri2(int ntri, mesh::vtxidx_t v0, mesh::vtxidx_t v1, cbm::INITOP op)
-	{
-		iop(op);
-		vertid(v0);
-		vertid(v1);
-		numtri(ntri);
-	}
-	void tri3(int ntri, mesh::vtxidx_t v0, mesh::vtxidx_t v1, mesh::vtxidx_t v2, cbm::INITOP op)
-	{
-		iop(op);
-		vertid(v0);
-		vertid(v1);
-		vertid(v2);
-		numtri(ntri);
-	}
-
+	// Connectivity primitives
 	void iop(cbm::INITOP op)
 	{
 		models.conn_iop.encode(coder, op);
@@ -165,11 +175,12 @@ private:
 	}
 };
 
+template <typename C = ArithCoders>
 struct reader {
-	HryModels &models;
-	arith::Decoder<> &coder;
+	HryModels<C> &models;
+	typename C::Decoder &coder;
 
-	reader(HryModels &_models, arith::Decoder<> &_coder) : models(_models), coder(_coder)
+	reader(HryModels<C> &_models, typename C::Decoder &_coder) : models(_models), coder(_coder)
 	{}
 
 	void order(int i)
@@ -214,11 +225,11 @@ struct reader {
 	}
 	uint32_t attr_ghist(mesh::listidx_t l)
 	{
-		models.attr_ghist[l]->template decode<uint32_t>(coder);
+		return models.attr_ghist[l]->template decode<uint32_t>(coder);
 	}
 	uint16_t attr_lhist(mesh::listidx_t l)
 	{
-		models.attr_lhist[l]->template decode<uint16_t>(coder);
+		return models.attr_lhist[l]->template decode<uint16_t>(coder);
 	}
 	mesh::regidx_t reg_face()
 	{
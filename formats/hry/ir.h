@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Symbol log: the uncoded symbols of connectivity, regions and attributes in the order io::writer codes them.
+ * A log is recorded once and re-coded with any backend and models, without the traversal and the predictions.
+ * Each record is a kind byte followed by varints; residuals follow their list index as raw bytes in the format of the list.
+ */
+
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+
+#include "io.h"
+#include "transform.h"
+#include "structs/mesh.h"
+
+namespace hry {
+namespace ir {
+
+enum Kind : uint8_t { ORDER, IOP, OP, ELEM, PART, VERTID, NUMTRI, DATA, GHIST, LHIST, REGFACE, REGVTX };
+
+// Writer, which appends to a log instead of coding
+struct writer : io::conn_writer<writer> {
+	std::string &log;
+
+	writer(std::string &_log) : log(_log)
+	{}
+
+	void order(int i)              { put(ORDER, i); }
+	void iop(cbm::INITOP op)       { put(IOP, op); }
+	void op(cbm::OP op)            { put(OP, op); }
+	void elem(int i)               { put(ELEM, transform::zigzag_encode(i)); }
+	void part(int p)               { put(PART, p); }
+	void vertid(mesh::vtxidx_t v)  { put(VERTID, v); }
+	void numtri(int n)             { if (n != 0) put(NUMTRI, n); }
+
+	void attr_data(mixing::View e, mesh::listidx_t l)
+	{
+		put(DATA, l);
+		log.append((const char*)e.data(), e.bytes());
+	}
+	void attr_ghist(uint32_t idx, mesh::listidx_t l)
+	{
+		put(GHIST, l);
+		varint(idx);
+	}
+	void attr_lhist(uint16_t idx, mesh::listidx_t l)
+	{
+		put(LHIST, l);
+		varint(idx);
+	}
+	void reg_face(mesh::regidx_t r) { put(REGFACE, r); }
+	void reg_vtx(mesh::regidx_t r)  { put(REGVTX, r); }
+
+private:
+	void put(Kind kind, uint32_t val)
+	{
+		log.push_back(kind);
+		varint(val);
+	}
+	void varint(uint32_t v)
+	{
+		for (; v >= 0x80; v >>= 7) log.push_back(char(v | 0x80));
+		log.push_back(char(v));
+	}
+};
+
+// Codes the log of mesh: connectivity and regions with conn, the symbols of list l with attr(l)
+template <typename W, typename A>
+void replay(std::string &log, mesh::Mesh &mesh, W &conn, A &&attr)
+{
+	std::size_t pos = 0;
+	auto varint = [&] () {
+		uint32_t v = 0;
+		for (int shift = 0; ; shift += 7) {
+			if (pos == log.size() || shift > 28) throw std::runtime_error("Invalid symbol log");
+			uint8_t b = log[pos++];
+			v |= uint32_t(b & 0x7f) << shift;
+			if (!(b & 0x80)) return v;
+		}
+	};
+	auto list = [&] () {
+		mesh::listidx_t l = varint();
+		if (l >= mesh.attrs.size()) throw std::runtime_error("Invalid symbol log");
+		return l;
+	};
+
+	while (pos < log.size()) {
+		Kind kind = (Kind)log[pos++];
+		mesh::listidx_t l;
+		switch (kind) {
+		case ORDER:   conn.order(varint()); break;
+		case IOP:     conn.iop((cbm::INITOP)varint()); break;
+		case OP:      conn.op((cbm::OP)varint()); break;
+		case ELEM:    conn.elem((int)transform::zigzag_decode(varint())); break;
+		case PART:    conn.part(varint()); break;
+		case VERTID:  conn.vertid(varint()); break;
+		case NUMTRI:  conn.numtri(varint()); break;
+		case REGFACE: conn.reg_face(varint()); break;
+		case REGVTX:  conn.reg_vtx(varint()); break;
+		case DATA: {
+			l = list();
+			const mixing::Fmt &fmt = mesh.attrs[l].fmt();
+			if (log.size() - pos < fmt.bytes()) throw std::runtime_error("Invalid symbol log");
+			attr(l).attr_data(mixing::View((unsigned char*)&log[pos], fmt), l);
+			pos += fmt.bytes();
+			break;
+		}
+		case GHIST:
+			l = list();
+			attr(l).attr_ghist(varint(), l);
+			break;
+		case LHIST:
+			l = list();
+			attr(l).attr_lhist(varint(), l);
+			break;
+		default:
+			throw std::runtime_error("Invalid symbol log");
+		}
+	}
+}
+
+}
+}
@@ -10,35 +10,74 @@
 #pragma once
 
 #include <vector>
+#include <stdexcept>
 
+#include "common.h"
 #include "arith/coder.h"
+#include "arith/range.h"
+#include "arith/rans.h"
 #include "arith/model.h"
 #include "arith/stat_adaptive.h"
+#include "arith/stat_small.h"
+#include "arith/stat_pow2.h"
+#include "arith/stat_static.h"
 #include "cbm/base.h"
 
 namespace hry {
 
 enum AttrType { DATA, HIST, LHIST };
 
-template <typename TF = uint64_t>
-struct CBMInitModel : arith::Model<TF> {
-	arith::AdaptiveStatisticsModule<> stat;
+// Bundles an entropy coder backend with a matching statistics module for the multi-symbol models
+template <typename E, typename D, typename S = arith::AdaptiveStatisticsModule<uint64_t, uint32_t, uint32_t, E::FREQ_BITS>>
+struct Coders {
+	typedef E Encoder;
+	typedef D Decoder;
+	typedef S Stat;
+};
+typedef Coders<arith::Encoder<>, arith::Decoder<>> ArithCoders;
+
+// Drives the models in the first pass of static coding
+typedef Coders<arith::NullEncoder, arith::NullDecoder, arith::CountingStatisticsModule<>> CountingCoders;
+
+template <typename F, typename E, typename D>
+void with_stat(uint8_t flags, F &&f)
+{
+	if (flags & STATIC) f(Coders<E, D, arith::StaticStatisticsModule<>>());
+	else if (flags & POW2) f(Coders<E, D, arith::Pow2StatisticsModule<>>());
+	else f(Coders<E, D>());
+}
+
+// Calls f with a default constructed Coders instance of the given backend and statistics mode (header flags)
+template <typename F>
+void with_coders(Backend backend, uint8_t flags, F &&f)
+{
+	switch (backend) {
+	case ARITH: with_stat<F, arith::Encoder<>, arith::Decoder<>>(flags, std::forward<F>(f)); break;
+	case RANGE: with_stat<F, arith::RangeEncoder, arith::RangeDecoder>(flags, std::forward<F>(f)); break;
+	case RANS:  with_stat<F, arith::RansEncoder<>, arith::RansDecoder<>>(flags, std::forward<F>(f)); break;
+	default: throw std::runtime_error("Unknown entropy coder backend");
+	}
+}
 
-	CBMInitModel() : stat(cbm::ILAST + 1)
+template <typename C = ArithCoders>
+struct CBMInitModel : arith::Model<typename C::Encoder, typename C::Decoder> {
+	arith::SmallStatisticsModule<cbm::ILAST + 1> stat;
+
+	CBMInitModel()
 	{
 		for (int i = cbm::IFIRST; i <= cbm::ILAST; ++i) {
 			stat.init(i);
 		}
 	}
 
-	void enc(arith::Encoder<TF> &coder, const unsigned char *s, int n)
+	void enc(typename C::Encoder &coder, const unsigned char *s, int n)
 	{
 		// TODO correct cast for s
 		const cbm::INITOP *sc = (const cbm::INITOP*)s;
 		coder(this->stat, *sc);
 		this->stat.inc(*sc);
 	}
-	void dec(arith::Decoder<TF> &coder, unsigned char *s, int n)
+	void dec(typename C::Decoder &coder, unsigned char *s, int n)
 	{
 		cbm::INITOP *sc = (cbm::INITOP*)s;
 		*sc = (cbm::INITOP)coder(this->stat);
@@ -46,14 +85,19 @@ struct CBMInitModel : arith::Model<TF> {
 	}
 };
 
-template <int MAXORDER, typename TF = uint64_t>
-struct CBMModel : arith::Model<TF> {
-	arith::AdaptiveStatisticsModule<> stat;
+template <int MAXORDER, typename C = ArithCoders>
+struct CBMModel : arith::Model<typename C::Encoder, typename C::Decoder> {
+	typedef arith::SmallStatisticsModule<cbm::LAST + 1> Stat;
+	typedef uint64_t TF;
+
+	static const TF CMAX = Stat::FFULL >> 1; // keeps the total of the table below 2^31
+
+	Stat stat;
 	TF c;
 	TF c_newvtx_i[MAXORDER], c_connfwd_i[MAXORDER];
 	int o;
 
-	CBMModel() : stat(cbm::LAST + 1)
+	CBMModel()
 	{
 		for (int i = cbm::FIRST; i <= cbm::LAST; ++i) {
 			stat.init(i);
@@ -71,7 +115,7 @@ struct CBMModel : arith::Model<TF> {
 		o = _o;
 	}
 
-	void enc(arith::Encoder<TF> &coder, const unsigned char *s, int n)
+	void enc(typename C::Encoder &coder, const unsigned char *s, int n)
 	{
 		const cbm::OP *sc = (const cbm::OP*)s;
 		this->set_orderfreqs();
@@ -79,7 +123,7 @@ struct CBMModel : arith::Model<TF> {
 		this->inc(*sc);
 	}
 
-	void dec(arith::Decoder<TF> &coder, unsigned char *s, int n)
+	void dec(typename C::Decoder &coder, unsigned char *s, int n)
 	{
 		cbm::OP *sc = (cbm::OP*)s;
 		this->set_orderfreqs();
@@ -104,7 +148,7 @@ private:
 		return o < MAXORDER ? o : MAXORDER - 1;
 	}
 
-	void inc(arith::AdaptiveStatisticsModule<>::SymType s)
+	void inc(Stat::SymType s)
 	{
 		int i = order2idx(o);
 		if (s == cbm::NEWVTX) {
@@ -116,94 +160,214 @@ private:
 		} else {
 			stat.inc(s);
 		}
+		if (c > CMAX) rescale();
+	}
+
+	void rescale()
+	{
+		c >>= 1;
+		for (int i = 0; i < MAXORDER; ++i) {
+			c_newvtx_i[i] = (c_newvtx_i[i] + 1) >> 1;
+			c_connfwd_i[i] = (c_connfwd_i[i] + 1) >> 1;
+		}
+	}
+};
+
+// Codes K components of the same type, which are STRIDE bytes apart, without dispatching per component
+template <typename M, int K, int STRIDE, typename E, typename D>
+struct AttrKernel : arith::Model<E, D> {
+	static const int BYTES = sizeof(typename M::ValueType);
+
+	M comps[K];
+
+	void enc(E &coder, const unsigned char *s, int n)
+	{
+		for (int i = 0; i < K; ++i) {
+			comps[i].M::enc(coder, s + i * STRIDE, BYTES);
+		}
+	}
+	void dec(D &coder, unsigned char *s, int n)
+	{
+		for (int i = 0; i < K; ++i) {
+			comps[i].M::dec(coder, s + i * STRIDE, BYTES);
+		}
+	}
+
+	void save(std::ostream &os) const
+	{
+		for (int i = 0; i < K; ++i) {
+			comps[i].save(os);
+		}
+	}
+	void load(std::istream &is)
+	{
+		for (int i = 0; i < K; ++i) {
+			comps[i].load(is);
+		}
 	}
 };
 
-template <typename S, typename TF = uint64_t>
-struct ModelVector : std::vector<arith::Model<TF>*>
+template <typename C = ArithCoders>
+struct ModelVector : std::vector<arith::Model<typename C::Encoder, typename C::Decoder>*>
 {
+	typedef typename C::Stat S;
+	typedef typename C::Encoder E;
+	typedef typename C::Decoder D;
+
+	template <typename T>
+	using Mult = arith::ModelMult<T, S, E, D>;
+	template <typename T>
+	using Binary = arith::ModelBinary<T, E, D>;
+
 	const mixing::Fmt &fmt;
+	bool fused; // a single kernel codes all components
 
-	ModelVector(const mixing::Fmt &_fmt) : fmt(_fmt)
+	ModelVector(const mixing::Fmt &_fmt, AttrModel mode = MULT) : fmt(_fmt)
 	{
+		switch (mode) {
+		case MULT:   fused = add_kernel<Mult>();   break;
+		case BINARY: fused = add_kernel<Binary>(); break;
+		default: throw std::runtime_error("Unknown attribute model");
+		}
+		if (fused) return;
+
 		for (int i = 0; i < fmt.size(); ++i) {
-			arith::Model<TF> *model;
-			switch (fmt.stype(i)) {
-			case mixing::FLOAT:  model = new arith::ModelMult<uint32_t, S, TF>(); break;
-			case mixing::DOUBLE: model = new arith::ModelMult<uint64_t, S, TF>(); break;
-			case mixing::ULONG:  model = new arith::ModelMult<uint64_t, S, TF>(); break;
-			case mixing::LONG:   model = new arith::ModelMult<int64_t,  S, TF>(); break;
-			case mixing::UINT:   model = new arith::ModelMult<uint32_t, S, TF>(); break;
-			case mixing::INT:    model = new arith::ModelMult<int32_t,  S, TF>(); break;
-			case mixing::USHORT: model = new arith::ModelMult<int16_t,  S, TF>(); break;
-			case mixing::SHORT:  model = new arith::ModelMult<uint16_t, S, TF>(); break;
-			case mixing::UCHAR:  model = new arith::ModelMult<int8_t,   S, TF>(); break;
-			case mixing::CHAR:   model = new arith::ModelMult<uint8_t,  S, TF>(); break;
+			switch (mode) {
+			case MULT:   this->push_back(create<Mult>(fmt.stype(i))); break;
+			case BINARY: this->push_back(create<Binary>(fmt.stype(i))); break;
 			}
-			this->push_back(model);
 		}
 	}
 
-	ModelVector(const ModelVector<S, TF>&) = delete;
-	ModelVector<S, TF> &operator=(const ModelVector<S, TF>&) = delete;
+	ModelVector(const ModelVector<C>&) = delete;
+	ModelVector<C> &operator=(const ModelVector<C>&) = delete;
 
 	~ModelVector()
 	{
-		for (int i = 0; i < fmt.size(); ++i) {
-			switch (fmt.stype(i)) {
-			case mixing::FLOAT:  delete (arith::ModelMult<uint32_t, S, TF>*)(*this)[i]; break;
-			case mixing::DOUBLE: delete (arith::ModelMult<uint64_t, S, TF>*)(*this)[i]; break;
-			case mixing::ULONG:  delete (arith::ModelMult<uint64_t, S, TF>*)(*this)[i]; break;
-			case mixing::LONG:   delete (arith::ModelMult<int64_t,  S, TF>*)(*this)[i]; break;
-			case mixing::UINT:   delete (arith::ModelMult<uint32_t, S, TF>*)(*this)[i]; break;
-			case mixing::INT:    delete (arith::ModelMult<int32_t,  S, TF>*)(*this)[i]; break;
-			case mixing::USHORT: delete (arith::ModelMult<int16_t,  S, TF>*)(*this)[i]; break;
-			case mixing::SHORT:  delete (arith::ModelMult<uint16_t, S, TF>*)(*this)[i]; break;
-			case mixing::UCHAR:  delete (arith::ModelMult<int8_t,   S, TF>*)(*this)[i]; break;
-			case mixing::CHAR:   delete (arith::ModelMult<uint8_t,  S, TF>*)(*this)[i]; break;
-			}
+		for (int i = 0; i < this->size(); ++i) {
+			delete (*this)[i];
 		}
 	}
 
-	void enc(arith::Encoder<TF> &coder, mixing::View v)
+	void enc(E &coder, mixing::View v)
 	{
+		if (fused) {
+			(*this)[0]->enc(coder, v.data(), v.bytes());
+			return;
+		}
 		for (int i = 0; i < fmt.size(); ++i) {
 			(*this)[i]->enc(coder, v.data(i), v.bytes(i));
 		}
 	}
 
-	void dec(arith::Decoder<TF> &coder, mixing::View v)
+	void dec(D &coder, mixing::View v)
 	{
+		if (fused) {
+			(*this)[0]->dec(coder, v.data(), v.bytes());
+			return;
+		}
 		for (int i = 0; i < fmt.size(); ++i) {
 			(*this)[i]->dec(coder, v.data(i), v.bytes(i));
 		}
 	}
+
+	void save(std::ostream &os) const
+	{
+		for (int i = 0; i < this->size(); ++i) {
+			(*this)[i]->save(os);
+		}
+	}
+	void load(std::istream &is)
+	{
+		for (int i = 0; i < this->size(); ++i) {
+			(*this)[i]->load(is);
+		}
+	}
+
+private:
+	template <template <typename> class M>
+	static arith::Model<E, D> *create(mixing::Type stype)
+	{
+		switch (stype) {
+		case mixing::FLOAT:  return new M<uint32_t>();
+		case mixing::DOUBLE: return new M<uint64_t>();
+		case mixing::ULONG:  return new M<uint64_t>();
+		case mixing::LONG:   return new M<int64_t>();
+		case mixing::UINT:   return new M<uint32_t>();
+		case mixing::INT:    return new M<int32_t>();
+		case mixing::USHORT: return new M<int16_t>();
+		case mixing::SHORT:  return new M<uint16_t>();
+		case mixing::UCHAR:  return new M<int8_t>();
+		case mixing::CHAR:   return new M<uint8_t>();
+		}
+		return nullptr;
+	}
+
+	static constexpr int signature(int bytes, int k, int stride)
+	{
+		return bytes << 16 | k << 8 | stride;
+	}
+
+	// Uses a kernel for the common signatures: float/double positions and normals, float texture coordinates,
+	// 8 bit colors and their quantized counterparts
+	template <template <typename> class M>
+	bool add_kernel()
+	{
+		int k = fmt.size();
+		mixing::Type st = fmt.uniform_stype();
+		if (k == 0 || st == mixing::NONE) return false;
+		for (int i = 1; i < k; ++i) {
+			if (fmt.type(i) != fmt.type(0)) return false;
+		}
+
+		arith::Model<E, D> *kernel;
+		switch (signature(mixing::SIZES[st], k, mixing::SIZES[fmt.type(0)])) {
+		case signature(4, 3, 4): kernel = new AttrKernel<M<uint32_t>, 3, 4, E, D>(); break;
+		case signature(4, 2, 4): kernel = new AttrKernel<M<uint32_t>, 2, 4, E, D>(); break;
+		case signature(2, 3, 4): kernel = new AttrKernel<M<uint16_t>, 3, 4, E, D>(); break;
+		case signature(2, 2, 4): kernel = new AttrKernel<M<uint16_t>, 2, 4, E, D>(); break;
+		case signature(8, 3, 8): kernel = new AttrKernel<M<uint64_t>, 3, 8, E, D>(); break;
+		case signature(4, 3, 8): kernel = new AttrKernel<M<uint32_t>, 3, 8, E, D>(); break;
+		case signature(2, 3, 8): kernel = new AttrKernel<M<uint16_t>, 3, 8, E, D>(); break;
+		case signature(1, 3, 1): kernel = new AttrKernel<M<uint8_t>,  3, 1, E, D>(); break;
+		case signature(1, 4, 1): kernel = new AttrKernel<M<uint8_t>,  4, 1, E, D>(); break;
+		default: return false;
+		}
+		this->push_back(kernel);
+		return true;
+	}
 };
 
+template <typename C = ArithCoders>
 struct HryModels {
-	CBMModel<8> conn_op;
-	CBMInitModel<> conn_iop;
-	arith::ModelMult<uint32_t, arith::AdaptiveStatisticsModule<>> conn_elem;
-	arith::ModelMult<uint16_t, arith::AdaptiveStatisticsModule<>> conn_part;
-	arith::ModelMult<uint32_t, arith::AdaptiveStatisticsModule<>> conn_vert;
-	arith::ModelMult<uint16_t, arith::AdaptiveStatisticsModule<>> conn_numtri;
-	arith::ModelMult<uint16_t, arith::AdaptiveStatisticsModule<>> conn_regface, conn_regvtx;
-
-	std::vector<arith::ModelMult<uint8_t, arith::AdaptiveStatisticsModule<>>*> attr_type;
-	std::vector<arith::ModelMult<uint32_t, arith::AdaptiveStatisticsModule<>>*> attr_ghist;
-	std::vector<arith::ModelMult<uint16_t, arith::AdaptiveStatisticsModule<>>*> attr_lhist;
-	std::vector<ModelVector<arith::AdaptiveStatisticsModule<>>*> attr_data;
-
-	HryModels(mesh::Mesh &mesh) :
+	template <typename T>
+	using Mult = arith::ModelMult<T, typename C::Stat, typename C::Encoder, typename C::Decoder>;
+
+	CBMModel<8, C> conn_op;
+	CBMInitModel<C> conn_iop;
+	Mult<uint32_t> conn_elem;
+	Mult<uint16_t> conn_part;
+	Mult<uint32_t> conn_vert;
+	Mult<uint16_t> conn_numtri;
+	Mult<uint16_t> conn_regface, conn_regvtx;
+
+	std::vector<Mult<uint8_t>*> attr_type;
+	std::vector<Mult<uint32_t>*> attr_ghist;
+	std::vector<Mult<uint16_t>*> attr_lhist;
+	std::vector<ModelVector<C>*> attr_data;
+	std::vector<bool> attr_bound; // only bound lists are known to the decoder
+
+	HryModels(mesh::Mesh &mesh, const std::vector<AttrModel> &attr_models = std::vector<AttrModel>()) :
 		conn_numtri(false), conn_regface(false), conn_regvtx(false)
 	{
 		for (int i = 0; i < mesh.attrs.size(); ++i) {
-			attr_type.push_back(new arith::ModelMult<uint8_t, arith::AdaptiveStatisticsModule<>>(false));
+			attr_type.push_back(new Mult<uint8_t>(false));
 			attr_type.back()->init(DATA); attr_type.back()->init(HIST);
 			if (mesh.attrs[i].target == mesh::attr::CORNER) attr_type.back()->init(LHIST);
-			attr_ghist.push_back(new arith::ModelMult<uint32_t, arith::AdaptiveStatisticsModule<>>());
-			attr_lhist.push_back(new arith::ModelMult<uint16_t, arith::AdaptiveStatisticsModule<>>());
-			attr_data.push_back(new ModelVector<arith::AdaptiveStatisticsModule<>>(mesh.attrs[i].fmt()));
+			attr_ghist.push_back(new Mult<uint32_t>());
+			attr_lhist.push_back(new Mult<uint16_t>());
+			attr_data.push_back(new ModelVector<C>(mesh.attrs[i].fmt(), i < attr_models.size() ? attr_models[i] : MULT));
+			attr_bound.push_back(mesh.attrs.bound(i));
 		}
 
 		for (mesh::Faces::EdgeIterator it = mesh.faces.edge_begin(); it != mesh.faces.edge_end(); ++it) {
@@ -234,6 +398,32 @@ struct HryModels {
 	{
 		conn_op.order(i);
 	}
+
+	// Static tables of all multi-symbol models; the CBM operation models always adapt
+	void save(std::ostream &os) const
+	{
+		conn_elem.save(os); conn_part.save(os); conn_vert.save(os);
+		conn_numtri.save(os); conn_regface.save(os); conn_regvtx.save(os);
+		for (int i = 0; i < attr_data.size(); ++i) {
+			if (!attr_bound[i]) continue;
+			attr_type[i]->save(os);
+			attr_ghist[i]->save(os);
+			attr_lhist[i]->save(os);
+			attr_data[i]->save(os);
+		}
+	}
+	void load(std::istream &is)
+	{
+		conn_elem.load(is); conn_part.load(is); conn_vert.load(is);
+		conn_numtri.load(is); conn_regface.load(is); conn_regvtx.load(is);
+		for (int i = 0; i < attr_data.size(); ++i) {
+			if (!attr_bound[i]) continue;
+			attr_type[i]->load(is);
+			attr_ghist[i]->load(is);
+			attr_lhist[i]->load(is);
+			attr_data[i]->load(is);
+		}
+	}
 };
 
 }
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Pipeline between the traversal and the entropy coding of the connectivity: the traversal
+ * passes its symbols through a ring buffer to a second thread, which codes them in the same
+ * order as io::writer would, so the bitstream does not change.
+ */
+
+#pragma once
+
+#include <thread>
+#include <exception>
+#include <cstdint>
+
+#include "io.h"
+#include "utils/threads.h"
+
+namespace hry {
+namespace pipe {
+
+enum Kind : uint8_t { ORDER, IOP, OP, ELEM, PART, VERTID, NUMTRI, STOP };
+
+struct Sym {
+	Kind kind;
+	uint32_t val;
+};
+
+// Writer of the traversal thread
+struct writer : io::conn_writer<writer> {
+	threads::Ring<Sym> &ring;
+
+	writer(threads::Ring<Sym> &_ring) : ring(_ring)
+	{}
+
+	void order(int i)              { put(ORDER, i); }
+	void iop(cbm::INITOP op)       { put(IOP, op); }
+	void op(cbm::OP op)            { put(OP, op); }
+	void elem(int i)               { put(ELEM, i); }
+	void part(int p)               { put(PART, p); }
+	void vertid(mesh::vtxidx_t v)  { put(VERTID, v); }
+	void numtri(int n)             { if (n != 0) put(NUMTRI, n); }
+
+	void put(Kind kind, uint32_t val)
+	{
+		ring.push(Sym{ kind, val });
+	}
+};
+
+// Calls f(pw) with a pipe writer pw, while the symbols written to pw are coded with wr on a second thread
+template <typename W, typename F>
+void run(W &wr, F &&f)
+{
+	threads::Ring<Sym> ring(1 << 16);
+	std::exception_ptr error;
+	std::thread coder([&] {
+		for (Sym s = ring.pop(); s.kind != STOP; s = ring.pop()) {
+			if (error) continue; // keep draining, the traversal must not block
+			try {
+				switch (s.kind) {
+				case ORDER:  wr.order(s.val); break;
+				case IOP:    wr.iop((cbm::INITOP)s.val); break;
+				case OP:     wr.op((cbm::OP)s.val); break;
+				case ELEM:   wr.elem((int)s.val); break;
+				case PART:   wr.part(s.val); break;
+				case VERTID: wr.vertid(s.val); break;
+				case NUMTRI: wr.numtri(s.val); break;
+				default:     break;
+				}
+			} catch (...) {
+				error = std::current_exception();
+			}
+		}
+	});
+
+	writer pw(ring);
+	try {
+		f(pw);
+	} catch (...) {
+		pw.put(STOP, 0);
+		coder.join();
+		throw;
+	}
+	pw.put(STOP, 0);
+	coder.join();
+	if (error) std::rethrow_exception(error);
+}
+
+}
+}
@@ -8,6 +8,7 @@
  */
 
 #include <stdexcept>
+#include <sstream>
 
 #include "reader.h"
 
@@ -15,7 +16,9 @@
 #include "attrcode.h"
 #include "io.h"
 #include "cbm/decoder.h"
+#include "chunks.h"
 #include "utils/progress.h"
+#include "utils/threads.h"
 
 namespace hry {
 namespace reader {
@@ -57,8 +60,12 @@ struct MeshHandle {
 
 struct HeaderReader {
 	std::istream &is;
+	Backend backend;
+	uint8_t flags;
+	uint32_t nvfe[3];
+	std::vector<AttrModel> attr_models;
 
-	HeaderReader(std::istream &_is) : is(_is)
+	HeaderReader(std::istream &_is) : is(_is), backend(ARITH), flags(0)
 	{}
 
 	void check_magic()
@@ -75,7 +82,10 @@ struct HeaderReader {
 	void read_syntax(mesh::Builder &builder)
 	{
 		check_magic();
-		uint32_t nvfe[3];
+		uint8_t b;
+		is.read((char*)&b, 1);
+		backend = (Backend)b;
+		is.read((char*)&flags, 1);
 		is.read((char*)nvfe, 3 * 4);
 
 		mesh::listidx_t num_bindings_face = 0, num_bindings_vtx = 0, num_bindings_corner = 0;
@@ -127,8 +137,10 @@ struct HeaderReader {
 			uint32_t s = 0;
 			mixing::Fmt fmt, fmt_dequant;
 			mixing::Interps interps;
+			uint8_t model = MULT;
 			if (targets[i] != mesh::attr::NONE) {
 				is.read((char*)&s, 4);
+				is.read((char*)&model, 1);
 
 				uint16_t nfmt;
 				is.read((char*)&nfmt, 2);
@@ -157,6 +169,7 @@ struct HeaderReader {
 					}
 				}
 			}
+			attr_models.push_back((AttrModel)model);
 			mesh::listidx_t l = builder.add_list(fmt, interps, targets[i]);
 			builder.alloc_attr(l, s);
 			is.read((char*)builder.mesh.attrs[l].min().data(), builder.mesh.attrs[l].min().bytes());
@@ -174,20 +187,183 @@ struct HeaderReader {
 	}
 };
 
-void read(std::istream &is, mesh::Mesh &mesh)
+// Decodes the connectivity with all regions from stream 0, then the lists from the following streams in parallel;
+// the streams of skipped lists are passed over
+template <typename C, typename P>
+void decompress_streams(std::istream &is, mesh::Builder &builder, HryModels<C> &models, const std::vector<bool> &skip, unsigned num_threads)
+{
+	mesh::Mesh &mesh = builder.mesh;
+	std::vector<mesh::listidx_t> lists;
+	for (mesh::listidx_t l = 0; l < mesh.attrs.size(); ++l) {
+		if (mesh.attrs.bound(l)) lists.push_back(l);
+	}
+
+	uint16_t nstreams;
+	is.read((char*)&nstreams, 2);
+	if (!is) throw std::runtime_error("Unexpected end of stream directory");
+	if (nstreams != lists.size() + 1) throw std::runtime_error("Stream directory does not match the attribute lists");
+	std::vector<uint64_t> bytes(nstreams);
+	is.read((char*)bytes.data(), nstreams * 8);
+	if (!is) throw std::runtime_error("Unexpected end of stream directory");
+	std::vector<std::string> data(nstreams);
+	std::vector<uint16_t> decoded; // streams of the lists to decode
+	for (uint16_t i = 0; i < nstreams; ++i) {
+		if (i != 0 && skip[lists[i - 1]]) {
+			is.ignore(bytes[i]);
+			mesh.attrs[lists[i - 1]].clear();
+			continue;
+		}
+		data[i].resize(bytes[i]);
+		is.read(&data[i][0], bytes[i]);
+		if (i != 0) decoded.push_back(i);
+	}
+	if (!is) throw std::runtime_error("Unexpected end of streams");
+
+	std::istringstream cis(data[0]);
+	typename C::Decoder coder(cis);
+	io::reader<C> rd(models, coder);
+	attrcode::AttrDecoder<io::reader<C>> ac(builder, rd, attrcode::NONE);
+	MeshHandle meshhandle(mesh);
+	cbm::decode<MeshHandle, io::reader<C>, attrcode::AttrDecoder<io::reader<C>>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, rd, ac);
+	ac.decode_regions();
+
+	P prog(decoded.size());
+	std::atomic<uint32_t> finished(0);
+	threads::Pool pool(num_threads);
+	pool.run(decoded.size(), [&] (std::size_t i) {
+		std::istringstream lis(data[decoded[i]]);
+		typename C::Decoder lcoder(lis);
+		io::reader<C> lrd(models, lcoder);
+		attrcode::AttrDecoder<io::reader<C>> lc(builder, lrd, lists[decoded[i] - 1]);
+		progress::voidhandle lprog;
+		lc.decode(lprog, ac.order);
+		prog(++finished);
+	});
+	prog.end();
+}
+
+// Decodes the mesh and removes the skipped lists afterwards
+template <typename C, typename P>
+void decompress(std::istream &is, mesh::Builder &builder, const HeaderReader &hr, const std::vector<bool> &skip, unsigned num_threads)
+{
+	HryModels<C> models(builder.mesh, hr.attr_models);
+	models.load(is); // static tables, if any
+	if (hr.flags & STREAMS) {
+		decompress_streams<C, P>(is, builder, models, skip, num_threads);
+	} else {
+		typename C::Decoder coder(is);
+		io::reader<C> rd(models, coder);
+		attrcode::AttrDecoder<io::reader<C>> ac(builder, rd);
+		MeshHandle meshhandle(builder.mesh);
+		cbm::decode<MeshHandle, io::reader<C>, attrcode::AttrDecoder<io::reader<C>>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, rd, ac);
+		P proga;
+		ac.decode(proga);
+	}
+	for (mesh::listidx_t l = 0; l < skip.size(); ++l) {
+		if (skip[l]) builder.unbind_list(l);
+	}
+}
+
+// Decodes the chunks in parallel and stitches them together
+void read_chunked(std::istream &is, mesh::Builder &builder, const HeaderReader &hr, const std::vector<bool> &skip, const Options &opts)
+{
+	mesh::Mesh &mesh = builder.mesh;
+	uint32_t nchunks;
+	is.read((char*)&nchunks, 4);
+	if (!is) throw std::runtime_error("Unexpected end of chunk table");
+	std::vector<chunks::Chunk> table(nchunks);
+	std::vector<uint64_t> bytes(nchunks);
+	for (uint32_t i = 0; i < nchunks; ++i) {
+		chunks::Chunk &chunk = table[i];
+		uint32_t nvfe[3];
+		is.read((char*)nvfe, 3 * 4);
+		chunk.nv = nvfe[0]; chunk.nf = nvfe[1]; chunk.ne = nvfe[2];
+		chunk.sizes.assign(mesh.attrs.size(), 0);
+		for (mesh::listidx_t l = 0; l < mesh.attrs.size(); ++l) {
+			if (mesh.attrs.bound(l)) is.read((char*)&chunk.sizes[l], 4);
+		}
+		uint32_t nshared;
+		is.read((char*)&nshared, 4);
+		if (!is) throw std::runtime_error("Unexpected end of chunk table");
+		chunk.shared.resize(nshared);
+		is.read((char*)chunk.shared.data(), nshared * 8);
+		is.read((char*)&bytes[i], 8);
+	}
+	for (uint32_t i = 0; i < nchunks; ++i) {
+		table[i].data.resize(bytes[i]);
+		is.read(&table[i].data[0], bytes[i]);
+	}
+	if (!is) throw std::runtime_error("Unexpected end of chunk data");
+
+	std::vector<mesh::Mesh*> meshes(nchunks, nullptr);
+	progress::handle prog(nchunks);
+	std::atomic<uint32_t> finished(0);
+	threads::Pool pool(opts.threads);
+	try {
+		pool.run(nchunks, [&] (std::size_t i) {
+			chunks::Chunk &chunk = table[i];
+			meshes[i] = new mesh::Mesh;
+			chunks::copy_syntax(mesh, *meshes[i]);
+			mesh::Builder cbuilder(*meshes[i]);
+			cbuilder.alloc_vtx(chunk.nv);
+			cbuilder.alloc_face(chunk.nf, chunk.ne);
+			for (mesh::listidx_t l = 0; l < mesh.attrs.size(); ++l) cbuilder.alloc_attr(l, chunk.sizes[l]);
+
+			std::istringstream cis(chunk.data);
+			with_coders(hr.backend, hr.flags, [&] (auto c) {
+				decompress<decltype(c), progress::voidhandle>(cis, cbuilder, hr, skip, 1); // the chunks are already decoded in parallel
+			});
+			std::string().swap(chunk.data);
+			prog(++finished);
+		});
+		prog.end();
+		for (mesh::listidx_t l = 0; l < skip.size(); ++l) {
+			if (skip[l]) builder.unbind_list(l); // same slots as in the chunks; the output has no bindings yet
+		}
+		chunks::merge(builder, meshes, table);
+	} catch (...) {
+		for (mesh::Mesh *m : meshes) delete m;
+		throw;
+	}
+}
+
+void read(std::istream &is, mesh::Mesh &mesh, const Options &opts)
 {
 	mesh::Builder builder(mesh);
 	HeaderReader hr(is);
 	hr.read_syntax(builder);
+	if (hr.flags & LOG) throw std::runtime_error("The file is a symbol log, which has to be re-coded first");
 
-	arith::Decoder<> coder(is);
-	HryModels models(builder.mesh);
-	io::reader rd(models, coder);
-	attrcode::AttrDecoder<io::reader> ac(builder, rd);
-	MeshHandle meshhandle(mesh);
-	cbm::decode<MeshHandle, io::reader, attrcode::AttrDecoder<io::reader>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, rd, ac);
-	progress::handle proga;
-	ac.decode(proga);
+	std::vector<bool> skip(mesh.attrs.size(), false);
+	for (mesh::listidx_t l = 0; l < mesh.attrs.size(); ++l) {
+		skip[l] = mesh.attrs.bound(l) && !opts.selects(l, mesh.attrs[l].interps());
+	}
+
+	if (hr.flags & CHUNKED) {
+		read_chunked(is, builder, hr, skip, opts);
+		return;
+	}
+	with_coders(hr.backend, hr.flags, [&] (auto c) {
+		decompress<decltype(c), progress::handle>(is, builder, hr, skip, opts.threads);
+	});
+}
+
+Syntax read_syntax(std::istream &is, mesh::Builder &builder)
+{
+	HeaderReader hr(is);
+	hr.read_syntax(builder);
+	return Syntax{ hr.flags, hr.nvfe[0], hr.nvfe[1], hr.nvfe[2] };
+}
+
+bool is_log(std::istream &is)
+{
+	std::istream::pos_type pos = is.tellg();
+	uint8_t head[8];
+	is.read((char*)head, 8);
+	bool log = is.gcount() == 8 && *(uint32_t*)head == htobe32(0xfaffafaf) && (head[7] & LOG);
+	is.clear();
+	is.seekg(pos);
+	return log;
 }
 
 }
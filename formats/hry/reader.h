@@ -10,13 +10,49 @@
 #pragma once
 
 #include <istream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 
 #include "structs/mesh.h"
 
 namespace hry {
 namespace reader {
 
-void read(std::istream &is, mesh::Mesh &mesh);
+struct Options {
+	unsigned threads; // for decoding chunks or streams, 0 uses all hardware threads
+	// Lists to decode, by index or by interpretation; all lists are decoded if both are empty.
+	// The other lists are removed from the mesh. Only files with separate streams skip their data without decoding it.
+	std::vector<mesh::listidx_t> lists;
+	std::vector<mixing::Interp> interps;
+
+	Options() : threads(0)
+	{}
+
+	bool selects(mesh::listidx_t l, const mixing::Interps &in) const
+	{
+		if (lists.empty() && interps.empty()) return true;
+		if (std::find(lists.begin(), lists.end(), l) != lists.end()) return true;
+		for (mixing::Interp i : interps) {
+			if (in.has(i)) return true;
+		}
+		return false;
+	}
+};
+
+// Sizes and flags (see common.h) of a file
+struct Syntax {
+	uint8_t flags;
+	mesh::vtxidx_t nv;
+	mesh::faceidx_t nf;
+	mesh::edgeidx_t ne;
+};
+
+void read(std::istream &is, mesh::Mesh &mesh, const Options &opts = Options());
+// Reads the header of a file into builder, which receives its lists and regions, but no elements
+Syntax read_syntax(std::istream &is, mesh::Builder &builder);
+// Whether the stream holds a symbol log, the stream position is kept
+bool is_log(std::istream &is);
 
 }
 }
@@ -7,29 +7,69 @@
  * of the BSD 3-Clause license. See the LICENSE.txt file for details.
  */
 
+#include <sstream>
+#include <memory>
+#include <algorithm>
+
 #include "writer.h"
 
 #include "common.h"
 #include "attrcode.h"
 #include "io.h"
 #include "cbm/encoder.h"
+#include "chunks.h"
+#include "pipe.h"
+#include "ir.h"
+#include "reader.h"
 #include "utils/progress.h"
+#include "utils/threads.h"
 
 namespace hry {
 namespace writer {
 
-struct MeshHandle {
-	typedef mesh::conn::fepair Edge;
+// Faces which are not traversed yet, one bit per face
+struct FaceSet {
+	std::vector<uint64_t> bits;
+	mesh::faceidx_t left;
 
-	std::unordered_set<mesh::faceidx_t> remaining_faces;
-	mesh::Mesh &mesh;
+	FaceSet(mesh::faceidx_t n) : bits((n + 63) / 64, ~uint64_t(0)), left(n)
+	{
+		if (n % 64 != 0) bits.back() = (uint64_t(1) << (n % 64)) - 1;
+	}
 
-	inline MeshHandle(mesh::Mesh &_mesh) : mesh(_mesh)
+	bool contains(mesh::faceidx_t f) const
 	{
-		for (mesh::faceidx_t i = 0; i < mesh.num_face(); ++i) {
-			remaining_faces.insert(i);
+		return (bits[f / 64] >> (f % 64)) & 1;
+	}
+	void erase(mesh::faceidx_t f)
+	{
+		bits[f / 64] &= ~(uint64_t(1) << (f % 64));
+		--left;
+	}
+	// first face >= f in the set, or at least the number of faces if there is none
+	mesh::faceidx_t next(mesh::faceidx_t f) const
+	{
+		std::size_t w = f / 64;
+		if (w >= bits.size()) return f;
+		uint64_t m = bits[w] & (~uint64_t(0) << (f % 64));
+		while (m == 0) {
+			if (++w == bits.size()) return w * 64;
+			m = bits[w];
 		}
+		return w * 64 + __builtin_ctzll(m);
 	}
+};
+
+struct MeshHandle {
+	typedef mesh::conn::fepair Edge;
+
+	FaceSet remaining_faces;
+	mesh::Mesh &mesh;
+	Seed seed;
+	mesh::faceidx_t cursor, border_cursor; // all remaining faces (with border edges) are behind the cursors
+
+	inline MeshHandle(mesh::Mesh &_mesh, Seed _seed) : remaining_faces(_mesh.num_face()), mesh(_mesh), seed(_seed), cursor(0), border_cursor(0)
+	{}
 
 	mesh::vtxidx_t num_vtx()
 	{
@@ -38,17 +78,16 @@ struct MeshHandle {
 
 	inline Edge choose_tri()
 	{
-		mesh::faceidx_t f = remaining_faces.find(0) == remaining_faces.end() ? *remaining_faces.begin() : 0;
-		Edge a = mesh::conn::fepair(f, 0);
+		mesh::faceidx_t f = seed == SEED_BORDER ? next_border() : next_first();
 		remaining_faces.erase(f);
-		return a;
+		return mesh::conn::fepair(f, 0);
 	}
 
 	inline Edge choose_twin(Edge i, bool &success)
 	{
 		mesh::conn::fepair a = mesh.conn.twin(i);
 		success = true;
-		if (a == i || remaining_faces.find(a.f()) == remaining_faces.end()) {
+		if (a == i || !remaining_faces.contains(a.f())) {
 			success = false;
 			return Edge();
 		}
@@ -58,7 +97,25 @@ struct MeshHandle {
 
 	inline bool empty()
 	{
-		return remaining_faces.empty();
+		return remaining_faces.left == 0;
+	}
+
+	// seed strategies, both cursors only advance
+	mesh::faceidx_t next_first()
+	{
+		cursor = remaining_faces.next(cursor);
+		return cursor;
+	}
+	mesh::faceidx_t next_border()
+	{
+		for (; border_cursor < mesh.num_face(); ++border_cursor) {
+			border_cursor = remaining_faces.next(border_cursor);
+			if (border_cursor >= mesh.num_face()) break;
+			for (mesh::ledgeidx_t e = 0; e < mesh.conn.num_edges(border_cursor); ++e) {
+				if (border(mesh::conn::fepair(border_cursor, e))) return border_cursor;
+			}
+		}
+		return next_first();
 	}
 
 	inline mesh::vtxidx_t org(Edge e)
@@ -114,10 +171,13 @@ struct HeaderWriter {
 		os.write((char*)ver, 2);
 	}
 
-	void write_syntax(mesh::Mesh &mesh)
+	void write_syntax(mesh::Mesh &mesh, const Options &opts, mesh::vtxidx_t nv, mesh::edgeidx_t ne)
 	{
 		write_magic();
-		uint32_t nvfe[] = { mesh.num_vtx(), mesh.num_face(), mesh.num_edge() };
+		uint8_t backend = opts.backend, flags = opts.flags();
+		os.write((char*)&backend, 1);
+		os.write((char*)&flags, 1);
+		uint32_t nvfe[] = { nv, mesh.num_face(), ne };
 		os.write((const char*)nvfe, 3 * 4);
 
 		// write reg bindings
@@ -154,6 +214,8 @@ struct HeaderWriter {
 			if (!seen_attrs[i]) continue;
 			uint32_t s = mesh.attrs[i].size();
 			os.write((char*)&s, 4);
+			uint8_t model = i < opts.attr_models.size() ? opts.attr_models[i] : MULT;
+			os.write((char*)&model, 1);
 
 			const mixing::Fmt &fmt = mesh.attrs[i].fmt();
 			uint16_t nfmt = fmt.size();
@@ -196,25 +258,348 @@ struct HeaderWriter {
 
 };
 
-void compress(std::ostream &os, mesh::Mesh &mesh)
+// Codes the connectivity, with pipeline the traversal and the coding run on two threads
+template <typename C>
+void encode_conn(MeshHandle &meshhandle, io::writer<C> &wr, attrcode::AttrCoder<io::writer<C>> &ac, bool pipeline)
+{
+	if (pipeline) {
+		pipe::run(wr, [&] (pipe::writer &pw) {
+			cbm::encode<MeshHandle, pipe::writer, attrcode::AttrCoder<io::writer<C>>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, pw, ac);
+		});
+	} else {
+		cbm::encode<MeshHandle, io::writer<C>, attrcode::AttrCoder<io::writer<C>>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, wr, ac);
+	}
+}
+
+// Codes the mesh, the residuals with num_threads threads; vorder receives the vertices in the order the decoder creates them
+template <typename C, typename P>
+void traverse(mesh::Mesh &mesh, HryModels<C> &models, typename C::Encoder &coder, Seed seed, unsigned num_threads, bool pipeline, std::vector<mesh::vtxidx_t> *vorder = nullptr)
+{
+	io::writer<C> wr(models, coder);
+	attrcode::AttrCoder<io::writer<C>> ac(mesh, wr);
+	MeshHandle meshhandle(mesh, seed);
+	encode_conn(meshhandle, wr, ac, pipeline);
+	if (vorder) {
+		for (mesh::conn::fepair e : ac.order) vorder->push_back(mesh.conn.org(e));
+	}
+	P proga;
+	threads::Pool pool(num_threads);
+	ac.encode(proga, &pool);
+}
+
+std::vector<mesh::listidx_t> bound_lists(mesh::Mesh &mesh)
+{
+	std::vector<mesh::listidx_t> lists;
+	for (mesh::listidx_t l = 0; l < mesh.attrs.size(); ++l) {
+		if (mesh.attrs.bound(l)) lists.push_back(l);
+	}
+	return lists;
+}
+
+// Same as traverse, but stream 0 receives the connectivity with all regions and stream i + 1 the list lists[i];
+// coder(i) returns the encoder of stream i, which is flushed afterwards. The lists are coded in parallel.
+template <typename C, typename P, typename F>
+void traverse_streams(mesh::Mesh &mesh, HryModels<C> &models, F &&coder, const std::vector<mesh::listidx_t> &lists, Seed seed, unsigned num_threads, bool pipeline, std::vector<mesh::vtxidx_t> *vorder = nullptr)
+{
+	io::writer<C> wr(models, coder(0));
+	attrcode::AttrCoder<io::writer<C>> ac(mesh, wr, attrcode::NONE);
+	MeshHandle meshhandle(mesh, seed);
+	encode_conn(meshhandle, wr, ac, pipeline);
+	if (vorder) {
+		for (mesh::conn::fepair e : ac.order) vorder->push_back(mesh.conn.org(e));
+	}
+	ac.encode_regions();
+	coder(0).flush();
+
+	P prog(lists.size());
+	std::atomic<uint32_t> finished(0);
+	threads::Pool pool(num_threads);
+	pool.run(lists.size(), [&] (std::size_t i) {
+		io::writer<C> lwr(models, coder(i + 1));
+		attrcode::AttrCoder<io::writer<C>> lc(mesh, lwr, lists[i]);
+		progress::voidhandle lprog;
+		lc.encode(lprog, ac.order, ac.order_f);
+		coder(i + 1).flush();
+		prog(++finished);
+	});
+	prog.end();
+}
+
+// First pass of static coding, returns the tables of all models
+template <typename P>
+std::string count(mesh::Mesh &mesh, const Options &opts)
+{
+	std::vector<mesh::conn::Conn::edgeorg> edges(mesh.conn.edges); // the traversal fixes bad borders in place
+	arith::NullEncoder coder;
+	HryModels<CountingCoders> models(mesh, opts.attr_models);
+	if (opts.streams) traverse_streams<CountingCoders, P>(mesh, models, [&] (std::size_t) -> arith::NullEncoder& { return coder; }, bound_lists(mesh), opts.seed, opts.threads, opts.pipeline);
+	else traverse<CountingCoders, P>(mesh, models, coder, opts.seed, opts.threads, opts.pipeline);
+	mesh.conn.edges.swap(edges);
+
+	std::ostringstream tables;
+	models.save(tables);
+	return tables.str();
+}
+
+// Stream directory: number of streams and their sizes, followed by the streams
+void write_streams(std::ostream &os, std::vector<std::ostringstream> &streams)
+{
+	uint16_t nstreams = streams.size();
+	os.write((const char*)&nstreams, 2);
+	std::vector<std::string> data;
+	for (std::ostringstream &s : streams) {
+		data.push_back(s.str());
+		uint64_t bytes = data.back().size();
+		os.write((const char*)&bytes, 8);
+	}
+	for (const std::string &d : data) os.write(d.data(), d.size());
+}
+
+template <typename C, typename P>
+void compress(std::ostream &os, mesh::Mesh &mesh, const Options &opts, const std::string &tables, std::vector<mesh::vtxidx_t> *vorder = nullptr)
 {
+	HryModels<C> models(mesh, opts.attr_models);
+	std::istringstream is(tables);
+	models.load(is);
+	if (!opts.streams) {
+		typename C::Encoder coder(os);
+		traverse<C, P>(mesh, models, coder, opts.seed, opts.threads, opts.pipeline, vorder);
+		coder.flush();
+		return;
+	}
+
+	std::vector<mesh::listidx_t> lists = bound_lists(mesh);
+	std::vector<std::ostringstream> streams(lists.size() + 1);
+	std::vector<std::unique_ptr<typename C::Encoder>> coders;
+	for (std::ostringstream &s : streams) coders.emplace_back(new typename C::Encoder(s));
+	traverse_streams<C, P>(mesh, models, [&] (std::size_t i) -> typename C::Encoder& { return *coders[i]; }, lists, opts.seed, opts.threads, opts.pipeline, vorder);
+	write_streams(os, streams);
+}
+
+// Codes the chunks in parallel, each one with its static tables (if any) in front of its stream
+void write_chunked(std::ostream &os, mesh::Mesh &mesh, const Options &opts)
+{
+	std::vector<std::vector<mesh::faceidx_t>> parts = chunks::partition(mesh, opts.chunk_faces);
+	std::vector<chunks::Chunk> table(parts.size());
+	std::vector<std::vector<mesh::vtxidx_t>> vorders(parts.size());
+
+	Options copts(opts);
+	copts.threads = 1; // the chunks are already coded in parallel
+	copts.pipeline = false;
+
+	progress::handle prog(parts.size());
+	std::atomic<uint32_t> finished(0);
+	threads::Pool pool(opts.threads);
+	pool.run(parts.size(), [&] (std::size_t i) {
+		mesh::Mesh sub;
+		std::vector<mesh::vtxidx_t> verts, vorder;
+		chunks::extract(mesh, parts[i], sub, verts);
+		std::vector<mesh::faceidx_t>().swap(parts[i]);
+
+		std::ostringstream cos;
+		std::string tables;
+		if (opts.static_models) {
+			tables = count<progress::voidhandle>(sub, copts);
+			cos.write(tables.data(), tables.size());
+		}
+		with_coders(opts.backend, opts.flags(), [&] (auto c) {
+			compress<decltype(c), progress::voidhandle>(cos, sub, copts, tables, &vorder);
+		});
+
+		chunks::Chunk &chunk = table[i];
+		chunk.nv = sub.num_vtx();
+		chunk.nf = sub.num_face();
+		chunk.ne = sub.num_edge();
+		for (mesh::listidx_t l = 0; l < sub.attrs.size(); ++l) chunk.sizes.push_back(sub.attrs[l].size());
+		chunk.data = cos.str();
+		for (mesh::vtxidx_t &v : vorder) v = verts[v];
+		vorders[i].swap(vorder);
+		prog(++finished);
+	});
+	prog.end();
+
+	mesh::vtxidx_t nv = chunks::stitch(mesh.num_vtx(), vorders, table);
+
 	HeaderWriter hw(os);
-	hw.write_syntax(mesh);
-	os.flush();
-	arith::Encoder<> coder(os);
-	HryModels models(mesh);
-	io::writer wr(models, coder);
-	attrcode::AttrCoder<io::writer> ac(mesh, wr);
-	MeshHandle meshhandle(mesh);
-	cbm::encode<MeshHandle, io::writer, attrcode::AttrCoder<io::writer>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, wr, ac);
-	progress::handle proga;
-	ac.encode(proga);
-	coder.flush();
+	hw.write_syntax(mesh, opts, nv, mesh.num_edge());
+	uint32_t nchunks = table.size();
+	os.write((const char*)&nchunks, 4);
+	for (const chunks::Chunk &chunk : table) {
+		uint32_t nvfe[] = { chunk.nv, chunk.nf, chunk.ne };
+		os.write((const char*)nvfe, 3 * 4);
+		for (mesh::listidx_t l = 0; l < mesh.attrs.size(); ++l) {
+			if (!mesh.attrs.bound(l)) continue;
+			os.write((const char*)&chunk.sizes[l], 4);
+		}
+		uint32_t nshared = chunk.shared.size();
+		os.write((const char*)&nshared, 4);
+		os.write((const char*)chunk.shared.data(), nshared * 8);
+		uint64_t bytes = chunk.data.size();
+		os.write((const char*)&bytes, 8);
+	}
+	for (const chunks::Chunk &chunk : table) {
+		os.write(chunk.data.data(), chunk.data.size());
+	}
+}
+
+// Writes the header followed by the size of the symbol log and the log
+void write_log(std::ostream &os, mesh::Mesh &mesh, const Options &opts)
+{
+	Options lopts; // backend and models are chosen when re-coding
+	lopts.symbol_log = true;
+	HeaderWriter hw(os);
+	hw.write_syntax(mesh, lopts, mesh.num_vtx(), mesh.num_edge());
+
+	std::string log;
+	ir::writer wr(log);
+	attrcode::AttrCoder<ir::writer> ac(mesh, wr);
+	MeshHandle meshhandle(mesh, opts.seed);
+	cbm::encode<MeshHandle, ir::writer, attrcode::AttrCoder<ir::writer>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, wr, ac);
+	progress::handle prog;
+	threads::Pool pool(opts.threads);
+	ac.encode(prog, &pool);
+
+	uint64_t bytes = log.size();
+	os.write((const char*)&bytes, 8);
+	os.write(log.data(), log.size());
+}
+
+void recode(std::istream &is, std::ostream &os, const Options &opts)
+{
+	if (opts.chunk_faces != 0) throw std::runtime_error("A symbol log cannot be re-coded into chunks");
+	if (opts.symbol_log) throw std::runtime_error("The input already is a symbol log");
+	mesh::Mesh mesh;
+	mesh::Builder builder(mesh);
+	reader::Syntax syntax = reader::read_syntax(is, builder);
+	if (!(syntax.flags & LOG)) throw std::runtime_error("Not a symbol log");
+	uint64_t bytes;
+	is.read((char*)&bytes, 8);
+	std::string log(bytes, '\0');
+	is.read(&log[0], bytes);
+	if (!is) throw std::runtime_error("Truncated symbol log");
+
+	HeaderWriter hw(os);
+	hw.write_syntax(mesh, opts, syntax.nv, syntax.ne);
+	std::string tables;
+	if (opts.static_models) {
+		arith::NullEncoder coder;
+		HryModels<CountingCoders> models(mesh, opts.attr_models);
+		io::writer<CountingCoders> wr(models, coder);
+		ir::replay(log, mesh, wr, [&] (mesh::listidx_t) -> io::writer<CountingCoders>& { return wr; });
+		std::ostringstream ts;
+		models.save(ts);
+		tables = ts.str();
+		os.write(tables.data(), tables.size());
+	}
+
+	with_coders(opts.backend, opts.flags(), [&] (auto c) {
+		typedef decltype(c) C;
+		HryModels<C> models(mesh, opts.attr_models);
+		std::istringstream ts(tables);
+		models.load(ts);
+		if (!opts.streams) {
+			typename C::Encoder coder(os);
+			io::writer<C> wr(models, coder);
+			ir::replay(log, mesh, wr, [&] (mesh::listidx_t) -> io::writer<C>& { return wr; });
+			coder.flush();
+			return;
+		}
+
+		// stream 0 receives connectivity and regions, as with traverse_streams
+		std::vector<mesh::listidx_t> lists = bound_lists(mesh);
+		std::vector<std::ostringstream> streams(lists.size() + 1);
+		std::vector<std::unique_ptr<typename C::Encoder>> coders;
+		std::vector<io::writer<C>> writers;
+		for (std::ostringstream &s : streams) {
+			coders.emplace_back(new typename C::Encoder(s));
+			writers.emplace_back(models, *coders.back());
+		}
+		std::vector<std::size_t> stream(mesh.attrs.size(), 0);
+		for (std::size_t i = 0; i < lists.size(); ++i) stream[lists[i]] = i + 1;
+		ir::replay(log, mesh, writers[0], [&] (mesh::listidx_t l) -> io::writer<C>& { return writers[stream[l]]; });
+		for (std::unique_ptr<typename C::Encoder> &coder : coders) coder->flush();
+		write_streams(os, streams);
+	});
+}
+
+// Codes the mesh with the connectivity symbols and the order of an earlier traversal
+template <typename C, typename P>
+void retraverse(mesh::Mesh &mesh, HryModels<C> &models, typename C::Encoder &coder, std::string &conn, const attrcode::AttrCoder<ir::writer> &tc, threads::Pool &pool)
+{
+	io::writer<C> wr(models, coder);
+	ir::replay(conn, mesh, wr, [&] (mesh::listidx_t) -> io::writer<C>& { return wr; });
+	attrcode::AttrCoder<io::writer<C>> ac(mesh, wr);
+	P prog;
+	ac.encode(prog, tc.order, tc.order_f, &pool);
 }
 
-void write(std::ostream &os, mesh::Mesh &mesh)
+void write_sweep(mesh::Mesh &mesh, const std::vector<std::vector<quant::Quant>> &settings, bool clear, const std::vector<std::ostream*> &outs, const Options &opts)
 {
-	compress(os, mesh);
+	if (opts.chunk_faces != 0 || opts.streams || opts.symbol_log) throw std::runtime_error("A quantization sweep cannot be chunked, split into streams or logged");
+
+	// the traversal does not depend on the attributes: keep its connectivity symbols and order
+	std::string conn;
+	ir::writer lwr(conn);
+	attrcode::AttrCoder<ir::writer> tc(mesh, lwr, attrcode::NONE);
+	MeshHandle meshhandle(mesh, opts.seed);
+	cbm::encode<MeshHandle, ir::writer, attrcode::AttrCoder<ir::writer>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, lwr, tc);
+
+	// each setting quantizes the original lists
+	std::vector<mesh::attr::Attr> orig(mesh.attrs.begin(), mesh.attrs.end());
+	threads::Pool pool(opts.threads);
+	for (std::size_t i = 0; i < settings.size(); ++i) {
+		std::copy(orig.begin(), orig.end(), mesh.attrs.begin());
+		quant::requant(mesh.attrs, settings[i], clear);
+
+		std::ostream &os = *outs[i];
+		HeaderWriter hw(os);
+		hw.write_syntax(mesh, opts, mesh.num_vtx(), mesh.num_edge());
+		std::string tables;
+		if (opts.static_models) {
+			arith::NullEncoder coder;
+			HryModels<CountingCoders> models(mesh, opts.attr_models);
+			retraverse<CountingCoders, progress::voidhandle>(mesh, models, coder, conn, tc, pool);
+			std::ostringstream ts;
+			models.save(ts);
+			tables = ts.str();
+			os.write(tables.data(), tables.size());
+		}
+		with_coders(opts.backend, opts.flags(), [&] (auto c) {
+			typedef decltype(c) C;
+			HryModels<C> models(mesh, opts.attr_models);
+			std::istringstream ts(tables);
+			models.load(ts);
+			typename C::Encoder coder(os);
+			retraverse<C, progress::handle>(mesh, models, coder, conn, tc, pool);
+			coder.flush();
+		});
+	}
+}
+
+void write(std::ostream &os, mesh::Mesh &mesh, const Options &opts)
+{
+	if (opts.symbol_log) {
+		if (opts.chunk_faces != 0 || opts.streams) throw std::runtime_error("A symbol log cannot be chunked or split into streams");
+		write_log(os, mesh, opts);
+		return;
+	}
+	if (opts.chunk_faces != 0) {
+		write_chunked(os, mesh, opts);
+		return;
+	}
+
+	HeaderWriter hw(os);
+	hw.write_syntax(mesh, opts, mesh.num_vtx(), mesh.num_edge());
+	std::string tables;
+	if (opts.static_models) {
+		tables = count<progress::handle>(mesh, opts);
+		os.write(tables.data(), tables.size());
+	}
+	os.flush();
+	uint8_t flags = opts.flags();
+	with_coders(opts.backend, flags, [&] (auto c) {
+		compress<decltype(c), progress::handle>(os, mesh, opts, tables);
+	});
 }
 
 }
@@ -9,14 +9,49 @@
 
 #pragma once
 
+#include <istream>
 #include <ostream>
+#include <vector>
 
+#include "common.h"
 #include "structs/mesh.h"
+#include "structs/quant.h"
 
 namespace hry {
 namespace writer {
 
-void write(std::ostream &os, mesh::Mesh &mesh);
+// Choice of the first face of each connected component
+enum Seed {
+	SEED_FIRST, // lowest remaining face index
+	SEED_BORDER // lowest remaining face with a border edge, if any, so open components start at their border
+};
+
+struct Options {
+	Backend backend;
+	bool pow2;
+	bool static_models; // two passes: gather statistics first, then code with static tables
+	std::vector<AttrModel> attr_models; // per list, lists without an entry use MULT
+	Seed seed;
+	uint32_t chunk_faces; // maximum number of faces per chunk, 0 codes the mesh as a whole
+	bool streams; // one stream per attribute list, so the lists are coded in parallel
+	unsigned threads; // for coding chunks, streams or residuals, 0 uses all hardware threads
+	bool pipeline; // traverse and code the connectivity on two threads
+	bool symbol_log; // write the uncoded symbols (see ir.h), which can be re-coded with other options
+
+	Options() : backend(ARITH), pow2(false), static_models(false), seed(SEED_FIRST), chunk_faces(0), streams(false), threads(0), pipeline(false), symbol_log(false)
+	{}
+
+	uint8_t flags() const
+	{
+		return (pow2 ? POW2 : 0) | (static_models ? STATIC : 0) | (chunk_faces != 0 ? CHUNKED : 0) | (streams ? STREAMS : 0) | (symbol_log ? LOG : 0);
+	}
+};
+
+void write(std::ostream &os, mesh::Mesh &mesh, const Options &opts = Options());
+// Codes a symbol log with the given options, without the traversal and the predictions
+void recode(std::istream &is, std::ostream &os, const Options &opts = Options());
+// Codes the mesh into outs[i] with the quantization settings[i] (see quant::requant), the traversal runs only once
+void write_sweep(mesh::Mesh &mesh, const std::vector<std::vector<quant::Quant>> &settings, bool clear, const std::vector<std::ostream*> &outs, const Options &opts = Options());
 
 }
 }
@@ -15,6 +15,10 @@
 #include <cmath>
 #include <fstream>
 #include <array>
+#include <cstring>
+#include <cctype>
+#include <sstream>
+#include <atomic>
 
 #include "reader.h"
 
@@ -23,33 +27,34 @@
 #include "structs/quant.h"
 #include "utils/io.h"
 #include "utils/progress.h"
+#include "utils/threads.h"
+#include "utils/parse.h"
 
 #define BUFSIZE 16384
 
 
-#line 80 "formats/obj/reader.rl"
+#line 86 "formats/obj/reader.rl"
 
 
 namespace obj {
 namespace reader {
 
 
-#line 38 "/home/max/repos/harry/formats/obj/reader.cc"
+#line 44 "/home/max/repos/harry/formats/obj/reader.cc"
 static const char _ObjParser_actions[] = {
 	0, 1, 0, 1, 2, 1, 3, 1, 
-	4, 1, 12, 1, 18, 1, 20, 1, 
-	21, 1, 22, 1, 23, 1, 24, 1, 
-	25, 1, 26, 1, 27, 1, 28, 2, 
-	0, 1, 2, 0, 3, 2, 6, 17, 
-	2, 7, 17, 2, 8, 17, 2, 9, 
-	10, 2, 11, 12, 2, 13, 14, 2, 
-	13, 15, 2, 13, 16, 2, 18, 0, 
-	2, 19, 20, 2, 21, 28, 2, 22, 
-	28, 2, 23, 28, 2, 24, 28, 2, 
-	25, 28, 2, 27, 28, 3, 5, 6, 
-	17, 3, 9, 11, 12, 3, 13, 15, 
-	16, 3, 18, 0, 1, 3, 18, 0, 
-	3
+	4, 1, 5, 1, 12, 1, 18, 1, 
+	20, 1, 21, 1, 22, 1, 23, 1, 
+	24, 1, 25, 1, 26, 1, 27, 1, 
+	28, 2, 0, 1, 2, 0, 3, 2, 
+	6, 17, 2, 7, 17, 2, 8, 17, 
+	2, 9, 10, 2, 11, 12, 2, 13, 
+	14, 2, 13, 15, 2, 13, 16, 2, 
+	18, 0, 2, 19, 20, 2, 21, 28, 
+	2, 22, 28, 2, 23, 28, 2, 24, 
+	28, 2, 25, 28, 2, 27, 28, 3, 
+	9, 11, 12, 3, 13, 15, 16, 3, 
+	18, 0, 1, 3, 18, 0, 3
 };
 
 static const short _ObjParser_key_offsets[] = {
@@ -567,183 +572,183 @@ static const short _ObjParser_trans_targs[] = {
 
 static const char _ObjParser_trans_actions[] = {
 	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 25, 25, 0, 25, 25, 46, 
-	89, 0, 49, 0, 52, 52, 52, 9, 
-	0, 0, 0, 46, 89, 0, 49, 0, 
-	52, 52, 52, 52, 52, 9, 0, 0, 
-	0, 0, 0, 46, 89, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 64, 0, 
-	0, 64, 64, 0, 0, 13, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 64, 0, 0, 64, 64, 
-	0, 0, 13, 11, 11, 0, 0, 0, 
-	0, 0, 31, 31, 1, 0, 0, 0, 
-	0, 34, 0, 0, 5, 0, 3, 0, 
-	37, 37, 0, 0, 3, 0, 0, 0, 
-	31, 31, 1, 0, 0, 0, 0, 34, 
-	0, 0, 5, 0, 3, 0, 37, 37, 
-	0, 0, 3, 0, 0, 0, 31, 31, 
-	1, 0, 0, 0, 0, 34, 0, 0, 
-	5, 0, 3, 0, 37, 37, 37, 37, 
+	0, 0, 27, 27, 0, 27, 27, 48, 
+	87, 0, 51, 0, 54, 54, 54, 11, 
+	0, 0, 0, 48, 87, 0, 51, 0, 
+	54, 54, 54, 54, 54, 11, 0, 0, 
+	0, 0, 0, 48, 87, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 66, 0, 
+	0, 66, 66, 0, 0, 15, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 66, 0, 0, 66, 66, 
+	0, 0, 15, 13, 13, 0, 0, 0, 
+	0, 0, 33, 33, 1, 0, 0, 0, 
+	0, 36, 0, 0, 5, 0, 3, 0, 
+	39, 39, 0, 0, 3, 0, 0, 0, 
+	33, 33, 1, 0, 0, 0, 0, 36, 
+	0, 0, 5, 0, 3, 0, 39, 39, 
+	0, 0, 3, 0, 0, 0, 33, 33, 
+	1, 0, 0, 0, 0, 36, 0, 0, 
+	5, 0, 3, 0, 39, 39, 39, 39, 
 	0, 0, 3, 0, 0, 0, 0, 0, 
-	31, 31, 1, 0, 0, 0, 0, 34, 
+	33, 33, 1, 0, 0, 0, 0, 36, 
 	0, 0, 0, 0, 5, 0, 3, 0, 
-	37, 37, 37, 37, 0, 0, 3, 0, 
-	0, 0, 0, 0, 31, 31, 1, 0, 
-	0, 0, 0, 34, 0, 0, 5, 0, 
-	3, 0, 37, 37, 0, 0, 3, 0, 
-	0, 0, 31, 31, 1, 0, 0, 0, 
-	0, 34, 0, 0, 5, 0, 3, 0, 
-	37, 37, 37, 37, 0, 0, 3, 0, 
-	0, 0, 0, 0, 31, 31, 1, 0, 
-	0, 0, 0, 34, 0, 0, 5, 0, 
-	3, 0, 37, 37, 37, 37, 0, 0, 
-	3, 0, 0, 0, 0, 0, 31, 31, 
-	1, 0, 0, 0, 0, 34, 0, 0, 
-	5, 0, 3, 0, 37, 37, 37, 37, 
+	39, 39, 39, 39, 0, 0, 3, 0, 
+	0, 0, 0, 0, 33, 33, 1, 0, 
+	0, 0, 0, 36, 0, 0, 5, 0, 
+	3, 0, 39, 39, 0, 0, 3, 0, 
+	0, 0, 33, 33, 1, 0, 0, 0, 
+	0, 36, 0, 0, 5, 0, 3, 0, 
+	39, 39, 39, 39, 0, 0, 3, 0, 
+	0, 0, 0, 0, 33, 33, 1, 0, 
+	0, 0, 0, 36, 0, 0, 5, 0, 
+	3, 0, 39, 39, 39, 39, 0, 0, 
+	3, 0, 0, 0, 0, 0, 33, 33, 
+	1, 0, 0, 0, 0, 36, 0, 0, 
+	5, 0, 3, 0, 39, 39, 39, 39, 
 	0, 0, 3, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 7, 0, 85, 85, 
-	85, 85, 7, 0, 37, 37, 37, 37, 
+	0, 9, 9, 0, 7, 0, 39, 39, 
+	39, 39, 7, 0, 39, 39, 39, 39, 
 	0, 0, 0, 5, 0, 0, 0, 0, 
-	0, 0, 0, 43, 43, 43, 43, 0, 
+	0, 0, 0, 45, 45, 45, 45, 0, 
 	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 43, 43, 
-	43, 43, 0, 0, 0, 0, 0, 0, 
-	0, 40, 40, 40, 40, 0, 0, 0, 
-	0, 7, 0, 85, 85, 85, 85, 7, 
-	0, 37, 37, 37, 37, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 45, 45, 
+	45, 45, 0, 0, 0, 0, 0, 0, 
+	0, 42, 42, 42, 42, 0, 9, 9, 
+	0, 7, 0, 39, 39, 39, 39, 7, 
+	0, 39, 39, 39, 39, 0, 0, 0, 
 	5, 0, 0, 0, 0, 0, 0, 0, 
-	43, 43, 43, 43, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 43, 43, 43, 43, 0, 
-	0, 0, 0, 0, 0, 0, 40, 40, 
-	40, 40, 0, 0, 0, 0, 7, 0, 
-	85, 85, 85, 85, 7, 0, 37, 37, 
-	37, 37, 0, 0, 0, 5, 0, 0, 
-	0, 0, 0, 0, 0, 43, 43, 43, 
-	43, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	43, 43, 43, 43, 0, 0, 0, 0, 
-	0, 0, 0, 40, 40, 40, 40, 0, 
-	0, 0, 0, 7, 0, 85, 85, 7, 
-	0, 37, 37, 0, 0, 0, 5, 0, 
-	0, 0, 0, 0, 0, 0, 43, 43, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 43, 
-	43, 0, 0, 0, 0, 0, 0, 0, 
-	40, 40, 0, 0, 0, 0, 7, 0, 
-	85, 85, 85, 85, 7, 0, 37, 37, 
-	37, 37, 0, 0, 0, 5, 0, 0, 
-	0, 0, 0, 0, 0, 43, 43, 43, 
-	43, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	43, 43, 43, 43, 0, 0, 0, 0, 
-	0, 0, 0, 40, 40, 40, 40, 0, 
-	0, 0, 0, 7, 0, 85, 85, 85, 
-	85, 7, 0, 37, 37, 37, 37, 0, 
+	45, 45, 45, 45, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 45, 45, 45, 45, 0, 
+	0, 0, 0, 0, 0, 0, 42, 42, 
+	42, 42, 0, 9, 9, 0, 7, 0, 
+	39, 39, 39, 39, 7, 0, 39, 39, 
+	39, 39, 0, 0, 0, 5, 0, 0, 
+	0, 0, 0, 0, 0, 45, 45, 45, 
+	45, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	45, 45, 45, 45, 0, 0, 0, 0, 
+	0, 0, 0, 42, 42, 42, 42, 0, 
+	9, 9, 0, 7, 0, 39, 39, 7, 
+	0, 39, 39, 0, 0, 0, 5, 0, 
+	0, 0, 0, 0, 0, 0, 45, 45, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 45, 
+	45, 0, 0, 0, 0, 0, 0, 0, 
+	42, 42, 0, 9, 9, 0, 7, 0, 
+	39, 39, 39, 39, 7, 0, 39, 39, 
+	39, 39, 0, 0, 0, 5, 0, 0, 
+	0, 0, 0, 0, 0, 45, 45, 45, 
+	45, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	45, 45, 45, 45, 0, 0, 0, 0, 
+	0, 0, 0, 42, 42, 42, 42, 0, 
+	9, 9, 0, 7, 0, 39, 39, 39, 
+	39, 7, 0, 39, 39, 39, 39, 0, 
 	0, 0, 5, 0, 0, 0, 0, 0, 
-	0, 0, 43, 43, 43, 43, 0, 0, 
+	0, 0, 45, 45, 45, 45, 0, 0, 
 	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 43, 43, 43, 
-	43, 0, 0, 0, 0, 0, 0, 0, 
-	40, 40, 40, 40, 0, 0, 0, 0, 
-	7, 0, 85, 85, 7, 0, 37, 37, 
+	0, 0, 0, 0, 0, 45, 45, 45, 
+	45, 0, 0, 0, 0, 0, 0, 0, 
+	42, 42, 42, 42, 0, 9, 9, 0, 
+	7, 0, 39, 39, 7, 0, 39, 39, 
 	0, 0, 0, 5, 0, 0, 0, 0, 
-	0, 0, 0, 43, 43, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 43, 43, 0, 0, 
-	0, 0, 0, 0, 0, 40, 40, 0, 
-	0, 0, 0, 7, 0, 85, 85, 7, 
-	0, 37, 37, 0, 0, 0, 5, 0, 
-	0, 0, 0, 0, 0, 0, 43, 43, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 43, 
-	43, 0, 0, 0, 0, 0, 0, 0, 
-	40, 40, 0, 0, 0, 0, 0, 0, 
-	97, 97, 61, 11, 11, 11, 11, 101, 
-	0, 0, 5, 0, 3, 0, 37, 37, 
-	0, 0, 3, 0, 0, 0, 31, 31, 
-	1, 0, 0, 0, 0, 34, 0, 0, 
-	5, 0, 3, 0, 37, 37, 0, 0, 
-	3, 0, 0, 0, 31, 31, 1, 0, 
-	0, 0, 0, 34, 0, 0, 5, 0, 
-	3, 0, 37, 37, 37, 37, 0, 0, 
+	0, 0, 0, 45, 45, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 45, 45, 0, 0, 
+	0, 0, 0, 0, 0, 42, 42, 0, 
+	9, 9, 0, 7, 0, 39, 39, 7, 
+	0, 39, 39, 0, 0, 0, 5, 0, 
+	0, 0, 0, 0, 0, 0, 45, 45, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 45, 
+	45, 0, 0, 0, 0, 0, 0, 0, 
+	42, 42, 0, 0, 0, 0, 0, 0, 
+	95, 95, 63, 13, 13, 13, 13, 99, 
+	0, 0, 5, 0, 3, 0, 39, 39, 
+	0, 0, 3, 0, 0, 0, 33, 33, 
+	1, 0, 0, 0, 0, 36, 0, 0, 
+	5, 0, 3, 0, 39, 39, 0, 0, 
+	3, 0, 0, 0, 33, 33, 1, 0, 
+	0, 0, 0, 36, 0, 0, 5, 0, 
+	3, 0, 39, 39, 39, 39, 0, 0, 
 	3, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 7, 0, 85, 85, 
-	85, 85, 7, 0, 37, 37, 37, 37, 
+	0, 9, 9, 0, 7, 0, 39, 39, 
+	39, 39, 7, 0, 39, 39, 39, 39, 
 	0, 0, 0, 5, 0, 0, 0, 0, 
-	0, 0, 0, 43, 43, 43, 43, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 43, 43, 
-	43, 43, 0, 0, 0, 0, 0, 0, 
-	0, 40, 40, 40, 40, 0, 0, 0, 
-	0, 7, 0, 85, 85, 7, 0, 37, 
-	37, 0, 0, 0, 5, 0, 0, 0, 
-	0, 0, 0, 0, 43, 43, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 43, 43, 0, 
-	0, 0, 0, 0, 0, 0, 40, 40, 
-	0, 0, 0, 0, 7, 0, 85, 85, 
-	7, 0, 37, 37, 0, 0, 0, 5, 
-	0, 0, 0, 0, 0, 0, 0, 43, 
-	43, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	43, 43, 0, 0, 0, 0, 0, 0, 
-	0, 40, 40, 0, 0, 0, 0, 0, 
-	0, 97, 97, 61, 11, 11, 11, 11, 
-	101, 0, 0, 5, 0, 3, 0, 37, 
-	37, 0, 0, 3, 0, 0, 0, 31, 
-	31, 1, 0, 0, 0, 0, 34, 0, 
-	0, 5, 0, 3, 0, 37, 37, 37, 
-	37, 0, 0, 3, 0, 0, 0, 0, 
-	0, 31, 31, 1, 0, 0, 0, 0, 
-	34, 0, 0, 0, 0, 5, 0, 3, 
-	0, 37, 37, 37, 37, 0, 0, 3, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 7, 0, 85, 85, 85, 85, 7, 
-	0, 37, 37, 37, 37, 0, 0, 0, 
+	0, 0, 0, 45, 45, 45, 45, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 45, 45, 
+	45, 45, 0, 0, 0, 0, 0, 0, 
+	0, 42, 42, 42, 42, 0, 9, 9, 
+	0, 7, 0, 39, 39, 7, 0, 39, 
+	39, 0, 0, 0, 5, 0, 0, 0, 
+	0, 0, 0, 0, 45, 45, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 45, 45, 0, 
+	0, 0, 0, 0, 0, 0, 42, 42, 
+	0, 9, 9, 0, 7, 0, 39, 39, 
+	7, 0, 39, 39, 0, 0, 0, 5, 
+	0, 0, 0, 0, 0, 0, 0, 45, 
+	45, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	45, 45, 0, 0, 0, 0, 0, 0, 
+	0, 42, 42, 0, 0, 0, 0, 0, 
+	0, 95, 95, 63, 13, 13, 13, 13, 
+	99, 0, 0, 5, 0, 3, 0, 39, 
+	39, 0, 0, 3, 0, 0, 0, 33, 
+	33, 1, 0, 0, 0, 0, 36, 0, 
+	0, 5, 0, 3, 0, 39, 39, 39, 
+	39, 0, 0, 3, 0, 0, 0, 0, 
+	0, 33, 33, 1, 0, 0, 0, 0, 
+	36, 0, 0, 0, 0, 5, 0, 3, 
+	0, 39, 39, 39, 39, 0, 0, 3, 
+	0, 0, 0, 0, 0, 0, 9, 9, 
+	0, 7, 0, 39, 39, 39, 39, 7, 
+	0, 39, 39, 39, 39, 0, 0, 0, 
 	5, 0, 0, 0, 0, 0, 0, 0, 
-	43, 43, 43, 43, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 43, 43, 43, 43, 0, 
-	0, 0, 0, 0, 0, 0, 40, 40, 
-	40, 40, 0, 0, 0, 0, 7, 0, 
-	85, 85, 85, 85, 7, 0, 37, 37, 
-	37, 37, 0, 0, 0, 5, 0, 0, 
-	0, 0, 0, 0, 0, 43, 43, 43, 
-	43, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	43, 43, 43, 43, 0, 0, 0, 0, 
-	0, 0, 0, 40, 40, 40, 40, 0, 
-	0, 0, 0, 7, 0, 85, 85, 7, 
-	0, 37, 37, 0, 0, 0, 5, 0, 
-	0, 0, 0, 0, 0, 0, 43, 43, 
-	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 43, 
-	43, 0, 0, 0, 0, 0, 0, 0, 
-	40, 40, 0, 0, 0, 64, 0, 0, 
-	64, 64, 0, 0, 64, 0, 0, 64, 
-	64, 0, 0, 0, 0, 0, 0, 46, 
-	0, 89, 0, 49, 0, 93, 93, 93, 
-	93, 55, 9, 0, 0, 0, 0, 0, 
-	46, 89, 0, 49, 0, 58, 58, 58, 
-	58, 9, 0, 0, 0, 46, 0, 89, 
-	0, 49, 0, 93, 93, 55, 9, 0, 
-	0, 0, 46, 89, 0, 49, 0, 58, 
-	58, 9, 0, 29, 29, 29, 29, 29, 
-	29, 29, 29, 29, 29, 29, 29, 29, 
-	0, 82, 82, 82, 82, 82, 82, 82, 
-	82, 82, 82, 82, 82, 82, 0, 70, 
-	70, 70, 70, 70, 70, 70, 70, 70, 
-	70, 70, 70, 70, 0, 67, 67, 67, 
-	67, 67, 67, 67, 67, 67, 67, 67, 
-	67, 67, 0, 73, 73, 73, 73, 73, 
-	73, 73, 73, 73, 73, 73, 73, 73, 
-	0, 79, 79, 79, 79, 79, 79, 79, 
-	79, 79, 79, 79, 79, 79, 0, 76, 
-	76, 76, 76, 76, 76, 76, 76, 76, 
-	76, 76, 76, 76, 0, 0
+	45, 45, 45, 45, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 45, 45, 45, 45, 0, 
+	0, 0, 0, 0, 0, 0, 42, 42, 
+	42, 42, 0, 9, 9, 0, 7, 0, 
+	39, 39, 39, 39, 7, 0, 39, 39, 
+	39, 39, 0, 0, 0, 5, 0, 0, 
+	0, 0, 0, 0, 0, 45, 45, 45, 
+	45, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	45, 45, 45, 45, 0, 0, 0, 0, 
+	0, 0, 0, 42, 42, 42, 42, 0, 
+	9, 9, 0, 7, 0, 39, 39, 7, 
+	0, 39, 39, 0, 0, 0, 5, 0, 
+	0, 0, 0, 0, 0, 0, 45, 45, 
+	0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 45, 
+	45, 0, 0, 0, 0, 0, 0, 0, 
+	42, 42, 0, 0, 0, 66, 0, 0, 
+	66, 66, 0, 0, 66, 0, 0, 66, 
+	66, 0, 0, 0, 0, 0, 0, 48, 
+	0, 87, 0, 51, 0, 91, 91, 91, 
+	91, 57, 11, 0, 0, 0, 0, 0, 
+	48, 87, 0, 51, 0, 60, 60, 60, 
+	60, 11, 0, 0, 0, 48, 0, 87, 
+	0, 51, 0, 91, 91, 57, 11, 0, 
+	0, 0, 48, 87, 0, 51, 0, 60, 
+	60, 11, 0, 31, 31, 31, 31, 31, 
+	31, 31, 31, 31, 31, 31, 31, 31, 
+	0, 84, 84, 84, 84, 84, 84, 84, 
+	84, 84, 84, 84, 84, 84, 0, 72, 
+	72, 72, 72, 72, 72, 72, 72, 72, 
+	72, 72, 72, 72, 0, 69, 69, 69, 
+	69, 69, 69, 69, 69, 69, 69, 69, 
+	69, 69, 0, 75, 75, 75, 75, 75, 
+	75, 75, 75, 75, 75, 75, 75, 75, 
+	0, 81, 81, 81, 81, 81, 81, 81, 
+	81, 81, 81, 81, 81, 81, 0, 78, 
+	78, 78, 78, 78, 78, 78, 78, 78, 
+	78, 78, 78, 78, 0, 0
 };
 
 static const char _ObjParser_eof_actions[] = {
@@ -787,7 +792,7 @@ static const char _ObjParser_eof_actions[] = {
 	0, 0, 0, 0, 0, 0, 0, 0, 
 	0, 0, 0, 0, 0, 0, 0, 0, 
 	0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 27, 17, 15, 19, 23, 21
+	0, 0, 29, 19, 17, 21, 25, 23
 };
 
 static const int ObjParser_start = 321;
@@ -797,7 +802,7 @@ static const int ObjParser_error = 0;
 static const int ObjParser_en_main = 321;
 
 
-#line 86 "formats/obj/reader.rl"
+#line 92 "formats/obj/reader.rl"
 
 typedef float real;
 static const mixing::Type REALMT = mixing::FLOAT;
@@ -817,6 +822,149 @@ inline int objidx(int n, int size)
 	return n - 1;
 }
 
+// Float in the syntax of the machine
+inline bool objfloat(const char *&p, const char *e, real &val)
+{
+	auto is = [&] (const char *s, const char *word) {
+		for (; *word; ++s, ++word) if (s == e || std::tolower(*s) != *word) return false;
+		return true;
+	};
+	auto digit = [&] (const char *s) { return s != e && *s >= '0' && *s <= '9'; };
+
+	const char *s = p;
+	if (is(s, "nan")) { val = NAN; p = s + 3; return true; }
+	if (is(s, "inf")) { val = INFINITY; p = s + (is(s, "infinity") ? 8 : 3); return true; }
+	if (s != e && (*s == '+' || *s == '-')) ++s;
+	if (digit(s)) {
+		while (digit(s)) ++s;
+		if (s != e && *s == '.') for (++s; digit(s); ++s);
+	} else if (s != e && *s == '.' && digit(s + 1)) {
+		for (++s; digit(s); ++s);
+	} else {
+		return false;
+	}
+	if (s != e && (*s == 'e' || *s == 'E')) {
+		if (s + 1 == e || (s[1] != '+' && s[1] != '-') || !digit(s + 2)) return false;
+		for (s += 2; digit(s); ++s);
+	}
+	const char *t = p;
+	if (!parse::real(t, s, val)) return false;
+	p = s;
+	return true;
+}
+inline bool objindex(const char *&p, const char *e, int &idx)
+{
+	const char *s = p;
+	bool neg = s != e && *s == '-';
+	if (neg) ++s;
+	if (s == e || *s < '0' || *s > '9') return false;
+	for (idx = 0; s != e && *s >= '0' && *s <= '9'; ++s) { idx *= 10; idx += *s - '0'; }
+	if (neg) idx = -idx;
+	p = s;
+	return true;
+}
+
+// Thrown by the parallel reader for lines, which it leaves to the machine
+struct Unsupported {};
+
+// Elements of a chunk of lines, parsed without the mesh
+struct Chunk {
+	const char *beg, *end;
+	std::vector<int> keys; // attribute lists as attr * 9 + n in the order of their first use
+	std::vector<real> coords[27];
+	std::vector<unsigned char> num[3]; // number of values of each vertex, texture coordinate and normal
+	std::vector<mesh::ledgeidx_t> corners;
+	std::vector<int> idx[3];
+	std::vector<unsigned char> has; // per face: 1 with texture coordinates, 2 with normals
+	std::vector<int> before; // per face: vertices, texture coordinates and normals of the chunk before it
+	struct Directive {
+		std::size_t face;
+		bool lib;
+		std::string name;
+	};
+	std::vector<Directive> dirs;
+
+	void parse()
+	{
+		static const unsigned char VALID[3][9] = { { 0, 0, 0, 1, 1, 0, 1, 1, 1 }, { 0, 0, 1, 1 }, { 0, 0, 0, 1 } };
+		int cnt[3] = { 0, 0, 0 };
+		bool used[27] = { false };
+		auto blank = [] (char c) { return c == ' ' || c == '\t'; };
+
+		for (const char *s = beg; s != end;) {
+			const char *e = (const char*)std::memchr(s, '\n', end - s);
+			if (e == NULL) throw Unsupported(); // the machine ignores a last line without line break
+			const char *next = e + 1;
+			if (e != s && e[-1] == '\r') --e;
+			if (std::memchr(s, '\r', e - s) != NULL) throw Unsupported();
+
+			const char *k = s;
+			while (k != e && blank(*k)) ++k;
+			if (k == e || *s == '#') { s = next; continue; } // empty line or comment
+			if (k != s) throw Unsupported();
+			while (k != e && !blank(*k)) ++k;
+			std::string kw(s, k);
+			if (k == e) throw Unsupported();
+
+			if (kw == "v" || kw == "vt" || kw == "vn") {
+				int attr = kw == "v" ? VERTEX : kw == "vt" ? TEX : NORMAL;
+				real vals[8];
+				int n = 0;
+				for (const char *t = k;;) {
+					while (t != e && blank(*t)) ++t;
+					if (t == e) break;
+					real val;
+					if (n == 8 || !objfloat(t, e, val) || (t != e && !blank(*t))) throw Unsupported();
+					vals[n++] = val;
+				}
+				if (!VALID[attr][n]) throw Unsupported();
+				int key = attr * 9 + n;
+				if (!used[key]) {
+					used[key] = true;
+					keys.push_back(key);
+				}
+				coords[key].insert(coords[key].end(), vals, vals + n);
+				num[attr].push_back(n);
+				++cnt[attr];
+			} else if (kw == "f") {
+				int c = 0, ct = 0, cn = 0;
+				for (const char *t = k;;) {
+					while (t != e && blank(*t)) ++t;
+					if (t == e) break;
+					int v;
+					if (!objindex(t, e, v)) throw Unsupported();
+					idx[VERTEX].push_back(v);
+					for (int a = TEX; a <= NORMAL && t != e && *t == '/'; ++a) {
+						++t;
+						if (objindex(t, e, v)) {
+							idx[a].push_back(v);
+							++(a == TEX ? ct : cn);
+							// the machine also takes the texture coordinate of v/t as normal
+							if (a == TEX && (t == e || blank(*t))) {
+								idx[NORMAL].push_back(v);
+								++cn;
+							}
+						}
+					}
+					if (t != e && !blank(*t)) throw Unsupported();
+					++c;
+				}
+				if (c < 2 || (ct != 0 && ct != c) || (cn != 0 && cn != c)) throw Unsupported();
+				corners.push_back(c);
+				has.push_back((ct != 0) | (cn != 0) << 1);
+				before.insert(before.end(), cnt, cnt + 3);
+			} else if (kw == "usemtl" || kw == "mtllib") {
+				// the machine keeps blanks inside the name, but only single separators and no trailing ones are unambiguous
+				if (k + 1 == e || blank(k[1]) || blank(e[-1])) throw Unsupported();
+				dirs.push_back(Directive{ corners.size(), kw == "mtllib", std::string(k + 1, e) });
+			} else if (kw != "o" && kw != "s" && kw != "g" && kw != "l" && kw != "p") {
+				throw Unsupported();
+			}
+			s = next;
+		}
+	}
+};
+
 static const int lut_interp[] = { mixing::POS, mixing::TEX, mixing::NORMAL };
 
 #define IL 9
@@ -930,6 +1078,22 @@ struct OBJReader {
 		normal_loc.push_back(std::make_pair(list, aidx));
 	}
 	void face(int *vi, bool has_t, int *ti, bool has_n, int *ni, int corners)
+	{
+		mesh::listidx_t tex_a = 0, normal_a = (mesh::listidx_t)has_t;
+		mesh::regidx_t r = face_region(has_t, ti, has_n, ni, corners);
+
+		// add face
+		mesh::faceidx_t fidx = builder.alloc_face(1, corners);
+		builder.face_reg(fidx, r);
+		builder.face_begin(corners);
+		for (int i = 0; i < corners; ++i) {
+			builder.set_org(vi[i]);
+			if (has_t) builder.bind_corner_attr(fidx, i, tex_a, tex_loc[ti[i]].second);
+			if (has_n) builder.bind_corner_attr(fidx, i, normal_a, normal_loc[ni[i]].second);
+		}
+		builder.face_end();
+	}
+	mesh::regidx_t face_region(bool has_t, int *ti, bool has_n, int *ni, int corners)
 	{
 		mesh::listidx_t tex_l = IL, normal_l = IL;
 
@@ -950,17 +1114,7 @@ struct OBJReader {
 			if (has_t) builder.bind_reg_cornerlist(r, tex_a, tex_l);
 			if (has_n) builder.bind_reg_cornerlist(r, normal_a, normal_l);
 		}
-
-		// add face
-		mesh::faceidx_t fidx = builder.alloc_face(1, corners);
-		builder.face_reg(fidx, r);
-		builder.face_begin(corners);
-		for (int i = 0; i < corners; ++i) {
-			builder.set_org(vi[i]);
-			if (has_t) builder.bind_corner_attr(fidx, i, tex_a, tex_loc[ti[i]].second);
-			if (has_n) builder.bind_corner_attr(fidx, i, normal_a, normal_loc[ni[i]].second);
-		}
-		builder.face_end();
+		return r;
 	}
 
 	// reader
@@ -971,7 +1125,9 @@ struct OBJReader {
 		prog.start(util::linenum_approx(is));
 		builder.init_bindings(0, 1, 2);
 
-		double fraction, denom, sign, val, exp, expmul;
+		real sign, val;
+		std::string num; // the characters of a float
+		bool frac;
 		int idx, idx_sign;
 		std::vector<int> fi[3];
 		real coords[8];
@@ -984,12 +1140,12 @@ struct OBJReader {
 		int cs;
 
 		
-#line 988 "/home/max/repos/harry/formats/obj/reader.cc"
+#line 1145 "/home/max/repos/harry/formats/obj/reader.cc"
 	{
 	cs = ObjParser_start;
 	}
 
-#line 272 "formats/obj/reader.rl"
+#line 429 "formats/obj/reader.rl"
 
 		while (!is.eof()) {
 			char *p = buf;
@@ -998,7 +1154,7 @@ struct OBJReader {
 			char *eof = is.eof() ? pe : nullptr;
 
 			
-#line 1002 "/home/max/repos/harry/formats/obj/reader.cc"
+#line 1159 "/home/max/repos/harry/formats/obj/reader.cc"
 	{
 	int _klen;
 	unsigned int _trans;
@@ -1072,122 +1228,122 @@ _match:
 		switch ( *_acts++ )
 		{
 	case 0:
-#line 32 "formats/obj/reader.rl"
-	{ sign = 1; val = 0; fraction = 0; denom = 1; exp = 0; expmul = 1; }
+#line 38 "formats/obj/reader.rl"
+	{ sign = 1; num.clear(); frac = false; }
 	break;
 	case 1:
-#line 33 "formats/obj/reader.rl"
-	{ sign = (*p) == '-' ? -1 : 1; }
+#line 39 "formats/obj/reader.rl"
+	{ sign = (*p) == '-' ? -1 : 1; num += (*p); }
 	break;
 	case 2:
-#line 34 "formats/obj/reader.rl"
-	{ fraction *= 10; fraction += (*p) - '0'; denom *= 10; }
+#line 40 "formats/obj/reader.rl"
+	{ if (!frac) num += '.'; frac = true; num += (*p); }
 	break;
 	case 3:
-#line 35 "formats/obj/reader.rl"
-	{ val *= 10; val += (*p) - '0'; }
+#line 41 "formats/obj/reader.rl"
+	{ num += (*p); }
 	break;
 	case 4:
-#line 36 "formats/obj/reader.rl"
-	{ exp *= 10; exp += (*p) - '0'; }
+#line 42 "formats/obj/reader.rl"
+	{ num += (*p); }
 	break;
 	case 5:
-#line 37 "formats/obj/reader.rl"
-	{ expmul = std::pow(10.0, exp); }
+#line 43 "formats/obj/reader.rl"
+	{ num += 'e'; num += (*p); }
 	break;
 	case 6:
-#line 38 "formats/obj/reader.rl"
-	{ val += fraction / denom; val *= sign * expmul; }
+#line 44 "formats/obj/reader.rl"
+	{ const char *t = num.c_str(); parse::real(t, t + num.size(), val); }
 	break;
 	case 7:
-#line 39 "formats/obj/reader.rl"
+#line 45 "formats/obj/reader.rl"
 	{ val = NAN; }
 	break;
 	case 8:
-#line 40 "formats/obj/reader.rl"
+#line 46 "formats/obj/reader.rl"
 	{ val = INFINITY * sign; }
 	break;
 	case 9:
-#line 52 "formats/obj/reader.rl"
+#line 58 "formats/obj/reader.rl"
 	{ idx_sign = 0; }
 	break;
 	case 10:
-#line 52 "formats/obj/reader.rl"
+#line 58 "formats/obj/reader.rl"
 	{ idx_sign = 1; }
 	break;
 	case 11:
-#line 52 "formats/obj/reader.rl"
+#line 58 "formats/obj/reader.rl"
 	{ idx = 0; }
 	break;
 	case 12:
-#line 52 "formats/obj/reader.rl"
+#line 58 "formats/obj/reader.rl"
 	{ idx *= 10; idx += (*p) - '0'; }
 	break;
 	case 13:
-#line 52 "formats/obj/reader.rl"
+#line 58 "formats/obj/reader.rl"
 	{ idx = idx_sign ? -idx : idx; }
 	break;
 	case 14:
-#line 54 "formats/obj/reader.rl"
+#line 60 "formats/obj/reader.rl"
 	{ fi[VERTEX].push_back(objidx(idx, vi[VERTEX])); }
 	break;
 	case 15:
-#line 55 "formats/obj/reader.rl"
+#line 61 "formats/obj/reader.rl"
 	{ fi[TEX].push_back(objidx(idx, vi[TEX])); }
 	break;
 	case 16:
-#line 56 "formats/obj/reader.rl"
+#line 62 "formats/obj/reader.rl"
 	{ fi[NORMAL].push_back(objidx(idx, vi[NORMAL])); }
 	break;
 	case 17:
-#line 58 "formats/obj/reader.rl"
+#line 64 "formats/obj/reader.rl"
 	{ coords[ncoord++] = val; }
 	break;
 	case 18:
-#line 59 "formats/obj/reader.rl"
+#line 65 "formats/obj/reader.rl"
 	{ ncoord = 0; }
 	break;
 	case 19:
-#line 63 "formats/obj/reader.rl"
+#line 69 "formats/obj/reader.rl"
 	{ name.clear(); }
 	break;
 	case 20:
-#line 63 "formats/obj/reader.rl"
+#line 69 "formats/obj/reader.rl"
 	{ name += (*p); }
 	break;
 	case 21:
-#line 65 "formats/obj/reader.rl"
+#line 71 "formats/obj/reader.rl"
 	{ usemtl(name); }
 	break;
 	case 22:
-#line 66 "formats/obj/reader.rl"
+#line 72 "formats/obj/reader.rl"
 	{ mtllib(name); }
 	break;
 	case 23:
-#line 67 "formats/obj/reader.rl"
+#line 73 "formats/obj/reader.rl"
 	{ ++vi[VERTEX]; vertex(coords, ncoord); }
 	break;
 	case 24:
-#line 68 "formats/obj/reader.rl"
+#line 74 "formats/obj/reader.rl"
 	{ ++vi[TEX]; tex(coords, ncoord); }
 	break;
 	case 25:
-#line 69 "formats/obj/reader.rl"
+#line 75 "formats/obj/reader.rl"
 	{ ++vi[NORMAL]; normal(coords, ncoord); }
 	break;
 	case 26:
-#line 70 "formats/obj/reader.rl"
+#line 76 "formats/obj/reader.rl"
 	{ fi[0].clear(); fi[1].clear(); fi[2].clear(); }
 	break;
 	case 27:
-#line 70 "formats/obj/reader.rl"
+#line 76 "formats/obj/reader.rl"
 	{ face(fi[VERTEX].data(), !fi[TEX].empty(), fi[TEX].data(), !fi[NORMAL].empty(), fi[NORMAL].data(), fi[VERTEX].size()); }
 	break;
 	case 28:
-#line 79 "formats/obj/reader.rl"
+#line 85 "formats/obj/reader.rl"
 	{ prog(line++); }
 	break;
-#line 1191 "/home/max/repos/harry/formats/obj/reader.cc"
+#line 1348 "/home/max/repos/harry/formats/obj/reader.cc"
 		}
 	}
 
@@ -1204,30 +1360,30 @@ _again:
 	while ( __nacts-- > 0 ) {
 		switch ( *__acts++ ) {
 	case 21:
-#line 65 "formats/obj/reader.rl"
+#line 71 "formats/obj/reader.rl"
 	{ usemtl(name); }
 	break;
 	case 22:
-#line 66 "formats/obj/reader.rl"
+#line 72 "formats/obj/reader.rl"
 	{ mtllib(name); }
 	break;
 	case 23:
-#line 67 "formats/obj/reader.rl"
+#line 73 "formats/obj/reader.rl"
 	{ ++vi[VERTEX]; vertex(coords, ncoord); }
 	break;
 	case 24:
-#line 68 "formats/obj/reader.rl"
+#line 74 "formats/obj/reader.rl"
 	{ ++vi[TEX]; tex(coords, ncoord); }
 	break;
 	case 25:
-#line 69 "formats/obj/reader.rl"
+#line 75 "formats/obj/reader.rl"
 	{ ++vi[NORMAL]; normal(coords, ncoord); }
 	break;
 	case 27:
-#line 70 "formats/obj/reader.rl"
+#line 76 "formats/obj/reader.rl"
 	{ face(fi[VERTEX].data(), !fi[TEX].empty(), fi[TEX].data(), !fi[NORMAL].empty(), fi[NORMAL].data(), fi[VERTEX].size()); }
 	break;
-#line 1231 "/home/max/repos/harry/formats/obj/reader.cc"
+#line 1388 "/home/max/repos/harry/formats/obj/reader.cc"
 		}
 	}
 	}
@@ -1235,20 +1391,157 @@ _again:
 	_out: {}
 	}
 
-#line 280 "formats/obj/reader.rl"
+#line 437 "formats/obj/reader.rl"
 
 			if (cs == ObjParser_error) throw std::runtime_error("Unable to parse this OBJ file");
 		}
 		prog.end();
 	}
+
+	// Parallel reader: the file is split into chunks at line boundaries, which are parsed concurrently. The elements
+	// are counted per chunk, stored at their prefix offsets and the faces are added in file order, which gives the
+	// same mesh as read_obj. Files with lines, which the chunks leave to the machine, are read by read_obj.
+	void read_obj_parallel(std::istream &is, const std::string &dir, threads::Pool &pool)
+	{
+		std::string body;
+		std::vector<char> block(1 << 20);
+		while (is.read(block.data(), block.size()) || is.gcount() != 0) body.append(block.data(), is.gcount());
+
+		const std::size_t CHUNK = 1 << 20;
+		std::vector<Chunk> chunks;
+		for (std::size_t b = 0; b < body.size();) {
+			std::size_t e = b + CHUNK >= body.size() ? std::string::npos : body.find('\n', b + CHUNK);
+			e = e == std::string::npos ? body.size() : e + 1;
+			chunks.emplace_back();
+			chunks.back().beg = body.data() + b;
+			chunks.back().end = body.data() + e;
+			b = e;
+		}
+
+		progress::handle prog;
+		prog.start(chunks.size() * 2);
+		std::atomic<uint32_t> done(0);
+		try {
+			pool.run(chunks.size(), [&] (std::size_t c) {
+				chunks[c].parse();
+				prog(++done);
+			});
+		} catch (const Unsupported&) {
+			prog.end();
+			std::istringstream ss(body);
+			read_obj(ss, dir);
+			return;
+		}
+		std::string().swap(body);
+
+		// lists and vertex regions in the order of their first use, offsets of each chunk
+		base = dir;
+		builder.init_bindings(0, 1, 2);
+		std::vector<std::array<mesh::attridx_t, 27>> rows(chunks.size() + 1);
+		std::vector<std::array<int, 3>> elems(chunks.size() + 1);
+		mesh::faceidx_t num_faces = 0;
+		mesh::edgeidx_t num_corners = 0;
+		rows[0].fill(0);
+		elems[0].fill(0);
+		for (std::size_t c = 0; c < chunks.size(); ++c) {
+			for (int key : chunks[c].keys) {
+				int attr = key / 9, n = key % 9;
+				mesh::listidx_t list = init_attr((Attrs)attr, n);
+				if (attr == VERTEX && vtx_reg[n] == IR) {
+					vtx_reg[n] = builder.add_vtx_region(1);
+					builder.bind_reg_vtxlist(vtx_reg[n], 0, list);
+				}
+			}
+			for (int key = 0; key < 27; ++key) rows[c + 1][key] = rows[c][key] + chunks[c].coords[key].size() / std::max(key % 9, 1);
+			for (int a = 0; a < 3; ++a) elems[c + 1][a] = elems[c][a] + chunks[c].num[a].size();
+			num_faces += chunks[c].corners.size();
+			num_corners += chunks[c].idx[VERTEX].size();
+		}
+		for (int key = 0; key < 27; ++key) {
+			if (rows.back()[key] != 0) builder.alloc_attr(attr_lists[key / 9][key % 9], rows.back()[key]);
+		}
+		if (elems.back()[VERTEX] != 0) builder.alloc_vtx(elems.back()[VERTEX]);
+		tex_loc.resize(elems.back()[TEX]);
+		normal_loc.resize(elems.back()[NORMAL]);
+		if (num_faces != 0) builder.alloc_face(num_faces, num_corners);
+
+		// attributes, vertices and absolute indices
+		pool.run(chunks.size(), [&] (std::size_t c) {
+			Chunk &ch = chunks[c];
+			mesh::attridx_t row[27];
+			std::copy(rows[c].begin(), rows[c].end(), row);
+			std::size_t off[27] = { 0 };
+			for (int a = 0; a < 3; ++a) {
+				for (std::size_t i = 0; i < ch.num[a].size(); ++i) {
+					int n = ch.num[a][i], key = a * 9 + n;
+					mesh::listidx_t list = attr_lists[a][n];
+					mesh::attridx_t r = row[key]++;
+					for (int j = 0; j < n; ++j) {
+						unsigned char *dst = builder.elem(list, r, j);
+						std::copy((unsigned char*)&ch.coords[key][off[key] + j], (unsigned char*)&ch.coords[key][off[key] + j + 1], dst);
+					}
+					off[key] += n;
+					mesh::attridx_t e = elems[c][a] + i;
+					if (a == VERTEX) {
+						builder.vtx_reg(e, vtx_reg[n]);
+						builder.bind_vtx_attr(e, 0, r);
+					} else {
+						(a == TEX ? tex_loc : normal_loc)[e] = std::make_pair(list, r);
+					}
+				}
+			}
+			for (std::vector<real> &v : ch.coords) std::vector<real>().swap(v);
+			std::size_t o[3] = { 0, 0, 0 };
+			for (std::size_t f = 0; f < ch.corners.size(); ++f) {
+				for (int a = 0; a < 3; ++a) {
+					if (a != VERTEX && !(ch.has[f] & a)) continue;
+					for (int i = 0; i < ch.corners[f]; ++i, ++o[a]) ch.idx[a][o[a]] = objidx(ch.idx[a][o[a]], elems[c][a] + ch.before[f * 3 + a]);
+				}
+			}
+			prog(++done);
+		});
+
+		// faces in file order
+		for (Chunk &ch : chunks) {
+			mesh::faceidx_t first = builder.add_faces(ch.corners);
+			std::size_t d = 0, o[3] = { 0, 0, 0 };
+			for (std::size_t f = 0; f < ch.corners.size(); ++f) {
+				for (; d < ch.dirs.size() && ch.dirs[d].face == f; ++d) {
+					if (ch.dirs[d].lib) mtllib(ch.dirs[d].name);
+					else usemtl(ch.dirs[d].name);
+				}
+				int corners = ch.corners[f];
+				bool has_t = ch.has[f] & 1, has_n = ch.has[f] & 2;
+				int *vi = ch.idx[VERTEX].data() + o[VERTEX], *ti = ch.idx[TEX].data() + o[TEX], *ni = ch.idx[NORMAL].data() + o[NORMAL];
+				mesh::listidx_t tex_a = 0, normal_a = (mesh::listidx_t)has_t;
+				builder.face_reg(first + f, face_region(has_t, ti, has_n, ni, corners));
+				for (int i = 0; i < corners; ++i) {
+					builder.init_org(first + f, i, vi[i]);
+					if (has_t) builder.bind_corner_attr(first + f, i, tex_a, tex_loc[ti[i]].second);
+					if (has_n) builder.bind_corner_attr(first + f, i, normal_a, normal_loc[ni[i]].second);
+				}
+				o[VERTEX] += corners;
+				if (has_t) o[TEX] += corners;
+				if (has_n) o[NORMAL] += corners;
+			}
+			for (; d < ch.dirs.size(); ++d) {
+				if (ch.dirs[d].lib) mtllib(ch.dirs[d].name);
+				else usemtl(ch.dirs[d].name);
+			}
+			builder.merge_faces(first);
+			ch = Chunk();
+		}
+		prog.end();
+	}
 };
 
-void read(std::istream &is, const std::string &dir, mesh::Mesh &mesh)
+void read(std::istream &is, const std::string &dir, mesh::Mesh &mesh, const Options &opts)
 {
 	mesh::Builder builder(mesh);
+	threads::Pool pool(opts.threads);
 
 	OBJReader reader(builder);
-	reader.read_obj(is, dir);
+	reader.read_obj_parallel(is, dir, pool);
 
 	quant::set_bounds(mesh.attrs);
 
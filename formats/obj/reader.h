@@ -17,7 +17,14 @@
 namespace obj {
 namespace reader {
 
-void read(std::istream &is, const std::string &dir, mesh::Mesh &mesh);
+struct Options {
+	unsigned threads; // for parsing chunks of the file, 0 uses all hardware threads
+
+	Options() : threads(0)
+	{}
+};
+
+void read(std::istream &is, const std::string &dir, mesh::Mesh &mesh, const Options &opts = Options());
 
 }
 }
@@ -13,6 +13,10 @@
 #include <cmath>
 #include <fstream>
 #include <array>
+#include <cstring>
+#include <cctype>
+#include <sstream>
+#include <atomic>
 
 #include "reader.h"
 
@@ -21,6 +25,8 @@
 #include "structs/quant.h"
 #include "utils/io.h"
 #include "utils/progress.h"
+#include "utils/threads.h"
+#include "utils/parse.h"
 
 #define BUFSIZE 16384
 
@@ -29,19 +35,19 @@ machine ObjParser;
 sp = (' ' | '\t')+;
 an = [^\r\n]*;
 
-action float_init { sign = 1; val = 0; fraction = 0; denom = 1; exp = 0; expmul = 1; }
-action float_sign { sign = fc == '-' ? -1 : 1; }
-action float_frac { fraction *= 10; fraction += fc - '0'; denom *= 10; }
-action float_int { val *= 10; val += fc - '0'; }
-action float_exp { exp *= 10; exp += fc - '0'; }
-action float_exp_fin { expmul = std::pow(10.0, exp); }
-action float_fin { val += fraction / denom; val *= sign * expmul; }
+action float_init { sign = 1; num.clear(); frac = false; }
+action float_sign { sign = fc == '-' ? -1 : 1; num += fc; }
+action float_frac { if (!frac) num += '.'; frac = true; num += fc; }
+action float_int { num += fc; }
+action float_exp { num += fc; }
+action float_exp_sign { num += 'e'; num += fc; }
+action float_fin { const char *t = num.c_str(); parse::real(t, t + num.size(), val); }
 action float_nan { val = NAN; }
 action float_inf { val = INFINITY * sign; }
 
 nan = [nN][aA][nN];
 inf = [iI][nN][fF]([iI][nN][iI][tT][yY])?;
-exp = ([eE][+\-][0-9]+ $float_exp %float_exp_fin);
+exp = ([eE][+\-] $float_exp_sign [0-9]+ $float_exp);
 float = (
           [+\-]? >float_init $float_sign
           (
@@ -102,6 +108,149 @@ inline int objidx(int n, int size)
 	return n - 1;
 }
 
+// Float in the syntax of the machine
+inline bool objfloat(const char *&p, const char *e, real &val)
+{
+	auto is = [&] (const char *s, const char *word) {
+		for (; *word; ++s, ++word) if (s == e || std::tolower(*s) != *word) return false;
+		return true;
+	};
+	auto digit = [&] (const char *s) { return s != e && *s >= '0' && *s <= '9'; };
+
+	const char *s = p;
+	if (is(s, "nan")) { val = NAN; p = s + 3; return true; }
+	if (is(s, "inf")) { val = INFINITY; p = s + (is(s, "infinity") ? 8 : 3); return true; }
+	if (s != e && (*s == '+' || *s == '-')) ++s;
+	if (digit(s)) {
+		while (digit(s)) ++s;
+		if (s != e && *s == '.') for (++s; digit(s); ++s);
+	} else if (s != e && *s == '.' && digit(s + 1)) {
+		for (++s; digit(s); ++s);
+	} else {
+		return false;
+	}
+	if (s != e && (*s == 'e' || *s == 'E')) {
+		if (s + 1 == e || (s[1] != '+' && s[1] != '-') || !digit(s + 2)) return false;
+		for (s += 2; digit(s); ++s);
+	}
+	const char *t = p;
+	if (!parse::real(t, s, val)) return false;
+	p = s;
+	return true;
+}
+inline bool objindex(const char *&p, const char *e, int &idx)
+{
+	const char *s = p;
+	bool neg = s != e && *s == '-';
+	if (neg) ++s;
+	if (s == e || *s < '0' || *s > '9') return false;
+	for (idx = 0; s != e && *s >= '0' && *s <= '9'; ++s) { idx *= 10; idx += *s - '0'; }
+	if (neg) idx = -idx;
+	p = s;
+	return true;
+}
+
+// Thrown by the parallel reader for lines, which it leaves to the machine
+struct Unsupported {};
+
+// Elements of a chunk of lines, parsed without the mesh
+struct Chunk {
+	const char *beg, *end;
+	std::vector<int> keys; // attribute lists as attr * 9 + n in the order of their first use
+	std::vector<real> coords[27];
+	std::vector<unsigned char> num[3]; // number of values of each vertex, texture coordinate and normal
+	std::vector<mesh::ledgeidx_t> corners;
+	std::vector<int> idx[3];
+	std::vector<unsigned char> has; // per face: 1 with texture coordinates, 2 with normals
+	std::vector<int> before; // per face: vertices, texture coordinates and normals of the chunk before it
+	struct Directive {
+		std::size_t face;
+		bool lib;
+		std::string name;
+	};
+	std::vector<Directive> dirs;
+
+	void parse()
+	{
+		static const unsigned char VALID[3][9] = { { 0, 0, 0, 1, 1, 0, 1, 1, 1 }, { 0, 0, 1, 1 }, { 0, 0, 0, 1 } };
+		int cnt[3] = { 0, 0, 0 };
+		bool used[27] = { false };
+		auto blank = [] (char c) { return c == ' ' || c == '\t'; };
+
+		for (const char *s = beg; s != end;) {
+			const char *e = (const char*)std::memchr(s, '\n', end - s);
+			if (e == NULL) throw Unsupported(); // the machine ignores a last line without line break
+			const char *next = e + 1;
+			if (e != s && e[-1] == '\r') --e;
+			if (std::memchr(s, '\r', e - s) != NULL) throw Unsupported();
+
+			const char *k = s;
+			while (k != e && blank(*k)) ++k;
+			if (k == e || *s == '#') { s = next; continue; } // empty line or comment
+			if (k != s) throw Unsupported();
+			while (k != e && !blank(*k)) ++k;
+			std::string kw(s, k);
+			if (k == e) throw Unsupported();
+
+			if (kw == "v" || kw == "vt" || kw == "vn") {
+				int attr = kw == "v" ? VERTEX : kw == "vt" ? TEX : NORMAL;
+				real vals[8];
+				int n = 0;
+				for (const char *t = k;;) {
+					while (t != e && blank(*t)) ++t;
+					if (t == e) break;
+					real val;
+					if (n == 8 || !objfloat(t, e, val) || (t != e && !blank(*t))) throw Unsupported();
+					vals[n++] = val;
+				}
+				if (!VALID[attr][n]) throw Unsupported();
+				int key = attr * 9 + n;
+				if (!used[key]) {
+					used[key] = true;
+					keys.push_back(key);
+				}
+				coords[key].insert(coords[key].end(), vals, vals + n);
+				num[attr].push_back(n);
+				++cnt[attr];
+			} else if (kw == "f") {
+				int c = 0, ct = 0, cn = 0;
+				for (const char *t = k;;) {
+					while (t != e && blank(*t)) ++t;
+					if (t == e) break;
+					int v;
+					if (!objindex(t, e, v)) throw Unsupported();
+					idx[VERTEX].push_back(v);
+					for (int a = TEX; a <= NORMAL && t != e && *t == '/'; ++a) {
+						++t;
+						if (objindex(t, e, v)) {
+							idx[a].push_back(v);
+							++(a == TEX ? ct : cn);
+							// the machine also takes the texture coordinate of v/t as normal
+							if (a == TEX && (t == e || blank(*t))) {
+								idx[NORMAL].push_back(v);
+								++cn;
+							}
+						}
+					}
+					if (t != e && !blank(*t)) throw Unsupported();
+					++c;
+				}
+				if (c < 2 || (ct != 0 && ct != c) || (cn != 0 && cn != c)) throw Unsupported();
+				corners.push_back(c);
+				has.push_back((ct != 0) | (cn != 0) << 1);
+				before.insert(before.end(), cnt, cnt + 3);
+			} else if (kw == "usemtl" || kw == "mtllib") {
+				// the machine keeps blanks inside the name, but only single separators and no trailing ones are unambiguous
+				if (k + 1 == e || blank(k[1]) || blank(e[-1])) throw Unsupported();
+				dirs.push_back(Directive{ corners.size(), kw == "mtllib", std::string(k + 1, e) });
+			} else if (kw != "o" && kw != "s" && kw != "g" && kw != "l" && kw != "p") {
+				throw Unsupported();
+			}
+			s = next;
+		}
+	}
+};
+
 static const int lut_interp[] = { mixing::POS, mixing::TEX, mixing::NORMAL };
 
 #define IL 9
@@ -215,6 +364,22 @@ struct OBJReader {
 		normal_loc.push_back(std::make_pair(list, aidx));
 	}
 	void face(int *vi, bool has_t, int *ti, bool has_n, int *ni, int corners)
+	{
+		mesh::listidx_t tex_a = 0, normal_a = (mesh::listidx_t)has_t;
+		mesh::regidx_t r = face_region(has_t, ti, has_n, ni, corners);
+
+		// add face
+		mesh::faceidx_t fidx = builder.alloc_face(1, corners);
+		builder.face_reg(fidx, r);
+		builder.face_begin(corners);
+		for (int i = 0; i < corners; ++i) {
+			builder.set_org(vi[i]);
+			if (has_t) builder.bind_corner_attr(fidx, i, tex_a, tex_loc[ti[i]].second);
+			if (has_n) builder.bind_corner_attr(fidx, i, normal_a, normal_loc[ni[i]].second);
+		}
+		builder.face_end();
+	}
+	mesh::regidx_t face_region(bool has_t, int *ti, bool has_n, int *ni, int corners)
 	{
 		mesh::listidx_t tex_l = IL, normal_l = IL;
 
@@ -235,17 +400,7 @@ struct OBJReader {
 			if (has_t) builder.bind_reg_cornerlist(r, tex_a, tex_l);
 			if (has_n) builder.bind_reg_cornerlist(r, normal_a, normal_l);
 		}
-
-		// add face
-		mesh::faceidx_t fidx = builder.alloc_face(1, corners);
-		builder.face_reg(fidx, r);
-		builder.face_begin(corners);
-		for (int i = 0; i < corners; ++i) {
-			builder.set_org(vi[i]);
-			if (has_t) builder.bind_corner_attr(fidx, i, tex_a, tex_loc[ti[i]].second);
-			if (has_n) builder.bind_corner_attr(fidx, i, normal_a, normal_loc[ni[i]].second);
-		}
-		builder.face_end();
+		return r;
 	}
 
 	// reader
@@ -256,7 +411,9 @@ struct OBJReader {
 		prog.start(util::linenum_approx(is));
 		builder.init_bindings(0, 1, 2);
 
-		double fraction, denom, sign, val, exp, expmul;
+		real sign, val;
+		std::string num; // the characters of a float
+		bool frac;
 		int idx, idx_sign;
 		std::vector<int> fi[3];
 		real coords[8];
@@ -282,14 +439,151 @@ struct OBJReader {
 		}
 		prog.end();
 	}
+
+	// Parallel reader: the file is split into chunks at line boundaries, which are parsed concurrently. The elements
+	// are counted per chunk, stored at their prefix offsets and the faces are added in file order, which gives the
+	// same mesh as read_obj. Files with lines, which the chunks leave to the machine, are read by read_obj.
+	void read_obj_parallel(std::istream &is, const std::string &dir, threads::Pool &pool)
+	{
+		std::string body;
+		std::vector<char> block(1 << 20);
+		while (is.read(block.data(), block.size()) || is.gcount() != 0) body.append(block.data(), is.gcount());
+
+		const std::size_t CHUNK = 1 << 20;
+		std::vector<Chunk> chunks;
+		for (std::size_t b = 0; b < body.size();) {
+			std::size_t e = b + CHUNK >= body.size() ? std::string::npos : body.find('\n', b + CHUNK);
+			e = e == std::string::npos ? body.size() : e + 1;
+			chunks.emplace_back();
+			chunks.back().beg = body.data() + b;
+			chunks.back().end = body.data() + e;
+			b = e;
+		}
+
+		progress::handle prog;
+		prog.start(chunks.size() * 2);
+		std::atomic<uint32_t> done(0);
+		try {
+			pool.run(chunks.size(), [&] (std::size_t c) {
+				chunks[c].parse();
+				prog(++done);
+			});
+		} catch (const Unsupported&) {
+			prog.end();
+			std::istringstream ss(body);
+			read_obj(ss, dir);
+			return;
+		}
+		std::string().swap(body);
+
+		// lists and vertex regions in the order of their first use, offsets of each chunk
+		base = dir;
+		builder.init_bindings(0, 1, 2);
+		std::vector<std::array<mesh::attridx_t, 27>> rows(chunks.size() + 1);
+		std::vector<std::array<int, 3>> elems(chunks.size() + 1);
+		mesh::faceidx_t num_faces = 0;
+		mesh::edgeidx_t num_corners = 0;
+		rows[0].fill(0);
+		elems[0].fill(0);
+		for (std::size_t c = 0; c < chunks.size(); ++c) {
+			for (int key : chunks[c].keys) {
+				int attr = key / 9, n = key % 9;
+				mesh::listidx_t list = init_attr((Attrs)attr, n);
+				if (attr == VERTEX && vtx_reg[n] == IR) {
+					vtx_reg[n] = builder.add_vtx_region(1);
+					builder.bind_reg_vtxlist(vtx_reg[n], 0, list);
+				}
+			}
+			for (int key = 0; key < 27; ++key) rows[c + 1][key] = rows[c][key] + chunks[c].coords[key].size() / std::max(key % 9, 1);
+			for (int a = 0; a < 3; ++a) elems[c + 1][a] = elems[c][a] + chunks[c].num[a].size();
+			num_faces += chunks[c].corners.size();
+			num_corners += chunks[c].idx[VERTEX].size();
+		}
+		for (int key = 0; key < 27; ++key) {
+			if (rows.back()[key] != 0) builder.alloc_attr(attr_lists[key / 9][key % 9], rows.back()[key]);
+		}
+		if (elems.back()[VERTEX] != 0) builder.alloc_vtx(elems.back()[VERTEX]);
+		tex_loc.resize(elems.back()[TEX]);
+		normal_loc.resize(elems.back()[NORMAL]);
+		if (num_faces != 0) builder.alloc_face(num_faces, num_corners);
+
+		// attributes, vertices and absolute indices
+		pool.run(chunks.size(), [&] (std::size_t c) {
+			Chunk &ch = chunks[c];
+			mesh::attridx_t row[27];
+			std::copy(rows[c].begin(), rows[c].end(), row);
+			std::size_t off[27] = { 0 };
+			for (int a = 0; a < 3; ++a) {
+				for (std::size_t i = 0; i < ch.num[a].size(); ++i) {
+					int n = ch.num[a][i], key = a * 9 + n;
+					mesh::listidx_t list = attr_lists[a][n];
+					mesh::attridx_t r = row[key]++;
+					for (int j = 0; j < n; ++j) {
+						unsigned char *dst = builder.elem(list, r, j);
+						std::copy((unsigned char*)&ch.coords[key][off[key] + j], (unsigned char*)&ch.coords[key][off[key] + j + 1], dst);
+					}
+					off[key] += n;
+					mesh::attridx_t e = elems[c][a] + i;
+					if (a == VERTEX) {
+						builder.vtx_reg(e, vtx_reg[n]);
+						builder.bind_vtx_attr(e, 0, r);
+					} else {
+						(a == TEX ? tex_loc : normal_loc)[e] = std::make_pair(list, r);
+					}
+				}
+			}
+			for (std::vector<real> &v : ch.coords) std::vector<real>().swap(v);
+			std::size_t o[3] = { 0, 0, 0 };
+			for (std::size_t f = 0; f < ch.corners.size(); ++f) {
+				for (int a = 0; a < 3; ++a) {
+					if (a != VERTEX && !(ch.has[f] & a)) continue;
+					for (int i = 0; i < ch.corners[f]; ++i, ++o[a]) ch.idx[a][o[a]] = objidx(ch.idx[a][o[a]], elems[c][a] + ch.before[f * 3 + a]);
+				}
+			}
+			prog(++done);
+		});
+
+		// faces in file order
+		for (Chunk &ch : chunks) {
+			mesh::faceidx_t first = builder.add_faces(ch.corners);
+			std::size_t d = 0, o[3] = { 0, 0, 0 };
+			for (std::size_t f = 0; f < ch.corners.size(); ++f) {
+				for (; d < ch.dirs.size() && ch.dirs[d].face == f; ++d) {
+					if (ch.dirs[d].lib) mtllib(ch.dirs[d].name);
+					else usemtl(ch.dirs[d].name);
+				}
+				int corners = ch.corners[f];
+				bool has_t = ch.has[f] & 1, has_n = ch.has[f] & 2;
+				int *vi = ch.idx[VERTEX].data() + o[VERTEX], *ti = ch.idx[TEX].data() + o[TEX], *ni = ch.idx[NORMAL].data() + o[NORMAL];
+				mesh::listidx_t tex_a = 0, normal_a = (mesh::listidx_t)has_t;
+				builder.face_reg(first + f, face_region(has_t, ti, has_n, ni, corners));
+				for (int i = 0; i < corners; ++i) {
+					builder.init_org(first + f, i, vi[i]);
+					if (has_t) builder.bind_corner_attr(first + f, i, tex_a, tex_loc[ti[i]].second);
+					if (has_n) builder.bind_corner_attr(first + f, i, normal_a, normal_loc[ni[i]].second);
+				}
+				o[VERTEX] += corners;
+				if (has_t) o[TEX] += corners;
+				if (has_n) o[NORMAL] += corners;
+			}
+			for (; d < ch.dirs.size(); ++d) {
+				if (ch.dirs[d].lib) mtllib(ch.dirs[d].name);
+				else usemtl(ch.dirs[d].name);
+			}
+			builder.merge_faces(first);
+			ch = Chunk();
+		}
+		prog.end();
+	}
 };
 
-void read(std::istream &is, const std::string &dir, mesh::Mesh &mesh)
+void read(std::istream &is, const std::string &dir, mesh::Mesh &mesh, const Options &opts)
 {
 	mesh::Builder builder(mesh);
+	threads::Pool pool(opts.threads);
 
 	OBJReader reader(builder);
-	reader.read_obj(is, dir);
+	reader.read_obj_parallel(is, dir, pool);
 
 	quant::set_bounds(mesh.attrs);
 
@@ -16,6 +16,9 @@
 #include <limits>
 #include <numeric>
 #include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <atomic>
 
 #include "structs/mixing.h"
 #include "structs/types.h"
@@ -23,6 +26,8 @@
 #include "utils/io.h"
 #include "utils/progress.h"
 #include "utils/endian.h"
+#include "utils/threads.h"
+#include "utils/parse.h"
 
 namespace ply {
 namespace reader {
@@ -126,6 +131,16 @@ struct Element : std::vector<Property> {
 	{
 		return std::vector<Property>::operator[](i);
 	}
+	// Bytes per record in binary files, -1 if the element has list properties
+	inline int stride() const
+	{
+		int bytes = 0;
+		for (const Property &prop : *this) {
+			if (prop.list_len_type != mixing::NONE) return -1;
+			bytes += mixing::SIZES[prop.type];
+		}
+		return bytes;
+	}
 
 	void init(std::vector<int> &perm, mixing::Fmt &fmt, mixing::Interps &interps) const
 	{
@@ -278,9 +293,15 @@ struct ASCIIReader {
 		case mixing::UINT:
 			is >> uval;
 			return cpval2ptr<uint32_t>(dst, uval);
-		case mixing::FLOAT:
-			is >> fval;
-			return cpval2ptr<float>(dst, fval);
+		case mixing::FLOAT: {
+			// rounded once, not through a double
+			float f = 0;
+			std::string tok;
+			is >> tok;
+			const char *p = tok.c_str();
+			parse::real(p, p + tok.size(), f);
+			return cpval2ptr<float>(dst, f);
+		}
 		case mixing::DOUBLE:
 			is >> fval;
 			return cpval2ptr<double>(dst, fval);
@@ -320,8 +341,181 @@ struct BinLEReader {
 	}
 };
 
+// Converts a value of n bytes from the byte order of the file to the host
+inline void to_host(unsigned char *p, int n, bool be)
+{
+	switch (n) {
+	case 2: { uint16_t v; std::memcpy(&v, p, 2); v = be ? be16toh(v) : le16toh(v); std::memcpy(p, &v, 2); break; }
+	case 4: { uint32_t v; std::memcpy(&v, p, 4); v = be ? be32toh(v) : le32toh(v); std::memcpy(p, &v, 4); break; }
+	case 8: { uint64_t v; std::memcpy(&v, p, 8); v = be ? be64toh(v) : le64toh(v); std::memcpy(p, &v, 8); break; }
+	}
+}
+
+// Reads the records of a binary element without list properties in blocks and scatters the properties to their attributes
+void readblocks(std::istream &is, const Header &header, const Element &elem, const std::vector<int> &perm, int list, mesh::Builder &builder, progress::handle &prog, uint32_t &cur)
+{
+	bool be = header.fmt == BIN_BE;
+	bool swap = be ? be16toh(1) != 1 : le16toh(1) != 1;
+	int stride = elem.stride();
+	std::vector<int> offs(elem.size()), sizes(elem.size());
+	for (int k = 0, off = 0; k < elem.size(); ++k) {
+		offs[k] = off;
+		sizes[k] = mixing::SIZES[elem[k].type];
+		off += sizes[k];
+	}
+
+	int block = std::max(1, (1 << 20) / stride);
+	std::vector<unsigned char> buf((std::size_t)std::min(block, elem.len) * stride);
+	for (int j = 0; j < elem.len;) {
+		int n = std::min(block, elem.len - j);
+		if (!is.read((char*)buf.data(), (std::streamsize)n * stride)) throw std::runtime_error("Unexpected end of file");
+		for (int r = 0; r < n; ++r, ++j) {
+			const unsigned char *rec = buf.data() + (std::size_t)r * stride;
+			for (int k = 0; k < elem.size(); ++k) {
+				unsigned char *dst = builder.elem(list, j, perm[k]);
+				if (dst == NULL) continue;
+				std::copy(rec + offs[k], rec + offs[k] + sizes[k], dst);
+				if (swap) to_host(dst, sizes[k], be);
+			}
+		}
+		prog(cur += n);
+	}
+}
+
+// Reads a value of the given type in the byte order of the file and converts it to an integer like the readers above
+inline uint64_t load(const unsigned char *p, Type type, bool be)
+{
+	unsigned char v[8];
+	std::copy(p, p + mixing::SIZES[type], v);
+	to_host(v, mixing::SIZES[type], be);
+	int8_t c; uint8_t uc; int16_t s; uint16_t us; int32_t i; uint32_t ui; float f; double d;
+	switch (type) {
+	case mixing::CHAR:   std::memcpy(&c, v, 1);  return c;
+	case mixing::UCHAR:  std::memcpy(&uc, v, 1); return uc;
+	case mixing::SHORT:  std::memcpy(&s, v, 2);  return s;
+	case mixing::USHORT: std::memcpy(&us, v, 2); return us;
+	case mixing::INT:    std::memcpy(&i, v, 4);  return i;
+	case mixing::UINT:   std::memcpy(&ui, v, 4); return ui;
+	case mixing::FLOAT:  std::memcpy(&f, v, 4);  return f;
+	case mixing::DOUBLE: std::memcpy(&d, v, 8);  return d;
+	default:             return 1;
+	}
+}
+
+// Reads the records of a binary face element in blocks: a sequential scan of the list lengths finds the records and
+// the number of corners of each face, then the records are decoded in parallel and the faces are merged in order
+void readfaces(std::istream &is, const Header &header, const Element &elem, const std::vector<int> &perm, int vi, mesh::Builder &builder, threads::Pool &pool, progress::handle &prog, uint32_t &cur)
+{
+	bool be = header.fmt == BIN_BE;
+	const int TASK = 4096;
+	std::vector<unsigned char> buf(1 << 22);
+	std::size_t fill = 0;
+	std::vector<std::size_t> recs;
+	std::vector<mesh::ledgeidx_t> ne;
+
+	for (int j = 0; j < elem.len;) {
+		// scan the complete records in the buffer
+		recs.clear();
+		ne.clear();
+		std::size_t pos = 0;
+		while (j + (int)recs.size() < elem.len) {
+			std::size_t p = pos;
+			mesh::ledgeidx_t n = 0;
+			bool complete = true;
+			for (int k = 0; k < elem.size() && complete; ++k) {
+				const Property &prop = elem[k];
+				uint64_t listlen = 1;
+				if (prop.list_len_type != mixing::NONE) {
+					if (fill - p < mixing::SIZES[prop.list_len_type]) { complete = false; break; }
+					listlen = load(buf.data() + p, prop.list_len_type, be);
+					p += mixing::SIZES[prop.list_len_type];
+					if (k == vi) n = listlen;
+				}
+				if (fill - p < listlen * mixing::SIZES[prop.type]) complete = false;
+				else p += listlen * mixing::SIZES[prop.type];
+			}
+			if (!complete) break;
+			recs.push_back(pos);
+			ne.push_back(n);
+			pos = p;
+		}
+
+		if (!recs.empty()) {
+			mesh::faceidx_t first = builder.add_faces(ne);
+			pool.run((recs.size() + TASK - 1) / TASK, [&] (std::size_t t) {
+				std::size_t end = std::min(recs.size(), (t + 1) * TASK);
+				for (std::size_t r = t * TASK; r < end; ++r) {
+					const unsigned char *p = buf.data() + recs[r];
+					mesh::faceidx_t f = first + r;
+					for (int k = 0; k < elem.size(); ++k) {
+						const Property &prop = elem[k];
+						int size = mixing::SIZES[prop.type];
+						if (prop.list_len_type == mixing::NONE) {
+							unsigned char *dst = builder.elem(0, f, perm[k]);
+							if (dst != NULL) {
+								std::copy(p, p + size, dst);
+								to_host(dst, size, be);
+							}
+							p += size;
+							continue;
+						}
+						uint64_t listlen = load(p, prop.list_len_type, be);
+						p += mixing::SIZES[prop.list_len_type];
+						if (k == vi) {
+							for (uint64_t c = 0; c < listlen; ++c) builder.init_org(f, c, load(p + c * size, prop.type, be));
+						}
+						p += listlen * size;
+					}
+				}
+			});
+			builder.merge_faces(first);
+			j += recs.size();
+			prog(cur += recs.size());
+		} else if (pos == 0 && fill == buf.size()) {
+			buf.resize(buf.size() * 2); // a single record exceeds the buffer
+		}
+
+		// move the incomplete record to the front and refill
+		std::copy(buf.begin() + pos, buf.begin() + fill, buf.begin());
+		fill -= pos;
+		if (j == elem.len) break;
+		is.read((char*)buf.data() + fill, buf.size() - fill);
+		if (is.gcount() == 0) throw std::runtime_error("Unexpected end of file");
+		fill += is.gcount();
+	}
+
+	// give back the bytes of the following elements
+	if (fill != 0) {
+		is.clear();
+		is.seekg(-(std::streamoff)fill, std::ios::cur);
+		if (!is) throw std::runtime_error("Input is not seekable");
+	}
+}
+
+// Parses a value of the given type at p like ASCIIReader
+inline uint64_t parseval(const char *&p, const char *end, unsigned char *dst, Type type)
+{
+	int64_t val;
+	uint64_t uval;
+	float fval;
+	double dval;
+	switch (type) {
+	case mixing::NONE:   return 1;
+	case mixing::CHAR:   if (!parse::sint(p, end, val))  break; return cpval2ptr<int8_t>(dst, val);
+	case mixing::UCHAR:  if (!parse::uint(p, end, uval)) break; return cpval2ptr<uint8_t>(dst, uval);
+	case mixing::SHORT:  if (!parse::sint(p, end, val))  break; return cpval2ptr<int16_t>(dst, val);
+	case mixing::USHORT: if (!parse::uint(p, end, uval)) break; return cpval2ptr<uint16_t>(dst, uval);
+	case mixing::INT:    if (!parse::sint(p, end, val))  break; return cpval2ptr<int32_t>(dst, val);
+	case mixing::UINT:   if (!parse::uint(p, end, uval)) break; return cpval2ptr<uint32_t>(dst, uval);
+	case mixing::FLOAT:  if (!parse::real(p, end, fval)) break; return cpval2ptr<float>(dst, fval);
+	case mixing::DOUBLE: if (!parse::real(p, end, dval)) break; return cpval2ptr<double>(dst, dval);
+	default:             break;
+	}
+	throw std::runtime_error("Invalid PLY value");
+}
+
 template <typename R>
-void readloop(std::istream &is, const Header &header, const std::vector<int> *perms, mesh::Builder &builder, R &&read)
+void readloop(std::istream &is, const Header &header, const std::vector<int> *perms, mesh::Builder &builder, threads::Pool &pool, R &&read)
 {
 	progress::handle prog;
 	int face_idx = header["face"];
@@ -336,7 +530,14 @@ void readloop(std::istream &is, const Header &header, const std::vector<int> *pe
 		const Element &elem = header[i];
 		unsigned char ign[8];
 
-		if (i == face_idx || i == vtx_idx) {
+		bool fixed = header.fmt != ASCII && elem.stride() > 0;
+
+		if ((i == face_idx || i == vtx_idx) && fixed) {
+			int list = i == face_idx ? 0 : 1;
+			readblocks(is, header, elem, perms[list], list, builder, prog, cur);
+		} else if (i == face_idx && header.fmt != ASCII && vi_idx != -1 && elem[vi_idx].list_len_type != mixing::NONE) {
+			readfaces(is, header, elem, perms[0], vi_idx, builder, pool, prog, cur);
+		} else if (i == face_idx || i == vtx_idx) {
 			int list = i == face_idx ? 0 : 1;
 			const std::vector<int> &perm = perms[list];
 
@@ -363,6 +564,9 @@ void readloop(std::istream &is, const Header &header, const std::vector<int> *pe
 				}
 				prog(cur++);
 			}
+		} else if (fixed) {
+			// ignore unknown elements
+			is.ignore((std::streamsize)elem.len * elem.stride());
 		} else {
 			// ignore unknown elements
 			for (int j = 0; j < elem.len; ++j) {
@@ -379,7 +583,112 @@ void readloop(std::istream &is, const Header &header, const std::vector<int> *pe
 	prog.end();
 }
 
-void read(std::istream &is, mesh::Mesh &mesh)
+// Reads an ASCII body with one record per line: the lines are found and parsed in parallel chunks, then the faces
+// are merged in order. Bodies, whose records do not match their lines, are read by readloop.
+void readascii(std::istream &is, const Header &header, const std::vector<int> *perms, mesh::Builder &builder, threads::Pool &pool)
+{
+	std::string body;
+	std::vector<char> block(1 << 20);
+	while (is.read(block.data(), block.size()) || is.gcount() != 0) body.append(block.data(), is.gcount());
+
+	// pass 1: starts of the non-blank lines, a line belongs to the chunk in which it starts
+	const std::size_t CHUNK = 1 << 20;
+	std::vector<std::vector<std::size_t>> starts((body.size() + CHUNK - 1) / CHUNK);
+	pool.run(starts.size(), [&] (std::size_t c) {
+		std::size_t i = c * CHUNK, e = std::min(body.size(), i + CHUNK);
+		if (c != 0 && body[i - 1] != '\n') i = std::min(body.find('\n', i), e - 1) + 1;
+		while (i < e) {
+			std::size_t j = i;
+			while (j < body.size() && body[j] != '\n' && parse::is_blank(body[j])) ++j;
+			if (j < body.size() && body[j] != '\n') starts[c].push_back(i);
+			j = body.find('\n', j);
+			i = j == std::string::npos ? body.size() : j + 1;
+		}
+	});
+	std::vector<std::size_t> lines;
+	for (const std::vector<std::size_t> &st : starts) lines.insert(lines.end(), st.begin(), st.end());
+	starts.clear();
+
+	// first line of each element
+	std::vector<std::size_t> base(header.size() + 1, 0);
+	for (int i = 0; i < header.size(); ++i) base[i + 1] = base[i] + (header[i].empty() ? 0 : header[i].len);
+	std::size_t total = base.back();
+	if (lines.size() < total) {
+		std::istringstream ss(body);
+		readloop(ss, header, perms, builder, pool, ASCIIReader());
+		return;
+	}
+
+	int face_idx = header["face"];
+	int vtx_idx = header["vertex"];
+	int vi_idx = header[face_idx]["vertex_indices"];
+	progress::handle prog;
+	prog.start(header[face_idx].len + header[vtx_idx].len);
+	std::atomic<uint32_t> done(0);
+
+	// pass 2: records, attributes are stored directly and the corners of the faces per task
+	struct Corners {
+		std::vector<mesh::ledgeidx_t> ne;
+		std::vector<mesh::vtxidx_t> org;
+	};
+	const std::size_t TASK = 16384;
+	std::vector<Corners> corners((total + TASK - 1) / TASK);
+	auto parse_task = [&] (std::size_t t) {
+		unsigned char ign[8];
+		std::size_t end = std::min(total, (t + 1) * TASK);
+		uint32_t n = 0;
+		int i = std::upper_bound(base.begin(), base.end(), t * TASK) - base.begin() - 1;
+		for (std::size_t r = t * TASK; r < end; ++r) {
+			while (r >= base[i + 1]) ++i;
+			const Element &elem = header[i];
+			int list = i == face_idx ? 0 : i == vtx_idx ? 1 : -1;
+			std::size_t j = r - base[i];
+			const char *p = body.data() + lines[r];
+			const char *e = (const char*)std::memchr(p, '\n', body.data() + body.size() - p);
+			if (e == NULL) e = body.data() + body.size();
+
+			for (int k = 0; k < elem.size(); ++k) {
+				const Property &prop = elem[k];
+				if (list != -1 && perms[list][k] != -1) { // attribute
+					unsigned char *dst = builder.elem(list, j, perms[list][k]);
+					parseval(p, e, dst != NULL ? dst : ign, prop.type);
+					continue;
+				}
+				uint64_t listlen = parseval(p, e, ign, prop.list_len_type);
+				bool conn = list == 0 && k == vi_idx && prop.list_len_type != mixing::NONE;
+				if (conn) corners[t].ne.push_back(listlen);
+				for (uint64_t l = 0; l < listlen; ++l) {
+					uint64_t v = parseval(p, e, ign, prop.type);
+					if (conn) corners[t].org.push_back(v);
+				}
+			}
+			if (parse::skip_blank(p, e) != e) throw std::runtime_error("Invalid PLY line");
+			if (list != -1) ++n;
+		}
+		prog(done += n);
+	};
+	try {
+		pool.run(corners.size(), parse_task);
+	} catch (const std::runtime_error&) { // records across lines
+		prog.end();
+		std::istringstream ss(body);
+		readloop(ss, header, perms, builder, pool, ASCIIReader());
+		return;
+	}
+
+	for (const Corners &c : corners) {
+		if (c.ne.empty()) continue;
+		mesh::faceidx_t first = builder.add_faces(c.ne);
+		std::size_t o = 0;
+		for (std::size_t f = 0; f < c.ne.size(); ++f) {
+			for (mesh::ledgeidx_t v = 0; v < c.ne[f]; ++v) builder.init_org(first + f, v, c.org[o++]);
+		}
+		builder.merge_faces(first);
+	}
+	prog.end();
+}
+
+void read(std::istream &is, mesh::Mesh &mesh, const Options &opts)
 {
 	mesh::Builder builder(mesh);
 	Header header = read_header(is);
@@ -412,16 +721,17 @@ void read(std::istream &is, mesh::Mesh &mesh)
 	}
 
 	// load mesh
+	threads::Pool pool(opts.threads);
 	switch (header.fmt)
 	{
 	case ASCII:
-		readloop(is, header, perms, builder, ASCIIReader());
+		readascii(is, header, perms, builder, pool);
 		break;
 	case BIN_BE:
-		readloop(is, header, perms, builder, BinBEReader());
+		readloop(is, header, perms, builder, pool, BinBEReader());
 		break;
 	case BIN_LE:
-		readloop(is, header, perms, builder, BinLEReader());
+		readloop(is, header, perms, builder, pool, BinLEReader());
 		break;
 	}
 
@@ -15,7 +15,14 @@
 namespace ply {
 namespace reader {
 
-void read(std::istream &is, mesh::Mesh &mesh);
+struct Options {
+	unsigned threads; // for decoding binary faces and ASCII bodies, 0 uses all hardware threads
+
+	Options() : threads(0)
+	{}
+};
+
+void read(std::istream &is, mesh::Mesh &mesh, const Options &opts = Options());
 
 }
 }
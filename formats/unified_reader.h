@@ -30,6 +30,19 @@ namespace unified {
 namespace reader {
 
 enum FileType { HRY, PLY, OBJ, UNKNOWN };
+
+struct Options {
+#ifdef WITH_HRY
+	hry::reader::Options hry;
+#endif
+#ifdef WITH_PLY
+	ply::reader::Options ply;
+#endif
+#ifdef WITH_OBJ
+	obj::reader::Options obj;
+#endif
+};
+
 FileType get_mesh_type(std::istream &is, const std::string &fn)
 {
 	std::string ext(fn.end() - 4, fn.end());
@@ -51,37 +64,37 @@ FileType get_mesh_type(std::istream &is, const std::string &fn)
 	throw std::runtime_error("Not a mesh file");
 }
 
-void read(std::istream &is, const std::string &fn, mesh::Mesh &mesh)
+void read(std::istream &is, const std::string &fn, mesh::Mesh &mesh, const Options &opts = Options())
 {
 	std::string dir = fn.substr(0, fn.find_last_of("/\\"));
 	switch (get_mesh_type(is, fn))
 	{
 #ifdef WITH_HRY
 	case HRY:
-		hry::reader::read(is, mesh);
+		hry::reader::read(is, mesh, opts.hry);
 		break;
 #endif
 #ifdef WITH_PLY
 	case PLY:
-		ply::reader::read(is, mesh);
+		ply::reader::read(is, mesh, opts.ply);
 		break;
 #endif
 #ifdef WITH_OBJ
 	case OBJ:
-		obj::reader::read(is, dir, mesh);
+		obj::reader::read(is, dir, mesh, opts.obj);
 		break;
 #endif
 	default:
 		throw std::runtime_error("Currently unimplemented");
 	}
 }
-std::size_t read(const std::string &fn, mesh::Mesh &mesh)
+std::size_t read(const std::string &fn, mesh::Mesh &mesh, const Options &opts = Options())
 {
 	std::ifstream is(fn, std::ifstream::binary);
 	is.seekg(0, std::ios::end);
 	std::size_t size = is.tellg();
 	is.seekg(0, std::ios::beg);
-	read(is, fn, mesh);
+	read(is, fn, mesh, opts);
 	return size;
 }
 
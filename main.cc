@@ -13,6 +13,8 @@
 #include <stdexcept>
 #include <chrono>
 #include <cstdlib>
+#include <fstream>
+#include <algorithm>
 
 #include "formats/unified_reader.h"
 #include "formats/unified_writer.h"
@@ -22,15 +24,17 @@
 
 struct Args {
 	struct Quant {
-		int l, o, q;
+		int l, o;
+		std::vector<int> q; // more than one value sweeps them
 	};
 	std::string in, out;
 	unified::writer::FileType fmt;
 	std::vector<Quant> quant;
 	bool clearquant;
-	bool ply_ascii;
+	unified::writer::Options wopts;
+	unified::reader::Options ropts;
 
-	Args(int argc, const char **argv) : fmt(unified::writer::UNKNOWN), ply_ascii(false), quant(false), clearquant(false)
+	Args(int argc, const char **argv) : fmt(unified::writer::UNKNOWN), quant(false), clearquant(false)
 	{
 		using namespace std::string_literals;
 		args::parser args(argc, argv, "Harry mesh compressor");
@@ -39,13 +43,27 @@ struct Args {
 		const int ARG_FMT = args.add_opt('f', "format",      "Enforce output format");
 		const int ARG_LST = args.add_opt('l', "list",        "Select attribute list");
 		const int ARG_ATT = args.add_opt('a', "attr",        "Select attribute");
-		const int ARG_QUA = args.add_opt('q', "quant",       "Quantization bits");
+		const int ARG_QUA = args.add_opt('q', "quant",       "Quantization bits, comma-separated values code one HRY file per combination");
 		const int ARG_CQU = args.add_opt('c', "clear-quant", "Clear all quantization first");
+		const int ARG_THR = args.add_opt('j', "threads",     "Number of threads, 0 uses all cores");
 #ifdef WITH_PLY
 		const int ARG_PAS = args.add_opt(     "ply-ascii",   "PLY writer: Use ASCII format");
 #endif
+#ifdef WITH_HRY
+		const int ARG_COD = args.add_opt(     "coder",       "HRY writer: Entropy coder (arith, range, rans)");
+		const int ARG_AMD = args.add_opt('m', "attr-model",  "HRY writer: Attribute model for the selected list (mult, binary)");
+		const int ARG_PW2 = args.add_opt(     "pow2",        "HRY writer: Keep model totals at powers of two");
+		const int ARG_STA = args.add_opt(     "static",      "HRY writer: Two passes with static model tables for fast decoding");
+		const int ARG_SED = args.add_opt(     "seed",        "HRY writer: First face of each component (first, border)");
+		const int ARG_CHK = args.add_opt(     "chunks",      "HRY writer: Code independent chunks of at most this many faces in parallel");
+		const int ARG_STR = args.add_opt(     "streams",     "HRY writer: Code each attribute list into its own stream in parallel");
+		const int ARG_PIP = args.add_opt(     "pipeline",    "HRY writer: Traverse and code the connectivity on two threads");
+		const int ARG_LOG = args.add_opt(     "symbol-log",  "HRY writer: Write the uncoded symbols, an input symbol log is re-coded with the given options");
+		const int ARG_OLS = args.add_opt(     "only-list",   "HRY reader: Decode this list and drop the unselected ones (repeatable)");
+		const int ARG_ONL = args.add_opt(     "only",        "HRY reader: Decode the lists with this interpretation (pos, normal, color, tex) and drop the unselected ones (repeatable)");
+#endif
 
-		int cur_l, cur_a = -1;
+		int cur_l = -1, cur_a = -1;
 		for (int arg = args.next(); arg != args::parser::end; arg = args.next()) {
 			if (arg == ARG_IN)       in         = args.val<std::string>();
 			else if (arg == ARG_OUT) out        = args.val<std::string>();
@@ -62,56 +80,200 @@ struct Args {
 			);
 			else if (arg == ARG_LST) cur_l      = args.val<int>();
 			else if (arg == ARG_ATT) cur_a      = args.val<int>();
-			else if (arg == ARG_QUA) { quant.push_back(Quant{ cur_l, cur_a, args.val<int>() }); cur_a = -1; }
+			else if (arg == ARG_QUA) { quant.push_back(Quant{ cur_l, cur_a, split(args.val<std::string>()) }); cur_a = -1; }
 			else if (arg == ARG_CQU) clearquant = true;
+			else if (arg == ARG_THR) {
+				int n = args.val<int>();
+				if (n < 0) throw std::runtime_error("Invalid number of threads");
+#ifdef WITH_HRY
+				wopts.hry.threads = ropts.hry.threads = n;
+#endif
+#ifdef WITH_PLY
+				ropts.ply.threads = n;
+#endif
+#ifdef WITH_OBJ
+				ropts.obj.threads = n;
+#endif
+			}
 #ifdef WITH_PLY
-			else if (arg == ARG_PAS) ply_ascii  = true;
+			else if (arg == ARG_PAS) wopts.ply_ascii = true;
+#endif
+#ifdef WITH_HRY
+			else if (arg == ARG_COD) wopts.hry.backend = args.map("arith"s, hry::ARITH, "range"s, hry::RANGE, "rans"s, hry::RANS);
+			else if (arg == ARG_PW2) wopts.hry.pow2 = true;
+			else if (arg == ARG_STA) wopts.hry.static_models = true;
+			else if (arg == ARG_SED) wopts.hry.seed = args.map("first"s, hry::writer::SEED_FIRST, "border"s, hry::writer::SEED_BORDER);
+			else if (arg == ARG_CHK) {
+				int n = args.val<int>();
+				if (n <= 0) throw std::runtime_error("Invalid chunk size");
+				wopts.hry.chunk_faces = n;
+			}
+			else if (arg == ARG_STR) wopts.hry.streams = true;
+			else if (arg == ARG_PIP) wopts.hry.pipeline = true;
+			else if (arg == ARG_LOG) wopts.hry.symbol_log = true;
+			else if (arg == ARG_OLS) {
+				int l = args.val<int>();
+				if (l < 0) throw std::runtime_error("Invalid list index");
+				ropts.hry.lists.push_back(l);
+			}
+			else if (arg == ARG_ONL) ropts.hry.interps.push_back(args.map("pos"s, mixing::POS, "normal"s, mixing::NORMAL, "color"s, mixing::COLOR, "tex"s, mixing::TEX));
+			else if (arg == ARG_AMD) {
+				if (cur_l < 0) throw std::runtime_error("Invalid list index");
+				std::vector<hry::AttrModel> &models = wopts.hry.attr_models;
+				if (cur_l >= models.size()) models.resize(cur_l + 1, hry::MULT);
+				models[cur_l] = args.map("mult"s, hry::MULT, "binary"s, hry::BINARY);
+			}
 #endif
 		}
 	}
+
+	static std::vector<int> split(const std::string &s)
+	{
+		std::vector<int> v;
+		for (std::size_t b = 0, e; b <= s.size(); b = e + 1) {
+			e = std::min(s.find(',', b), s.size());
+			v.push_back(std::atoi(s.substr(b, e - b).c_str()));
+		}
+		return v;
+	}
+
+	bool sweep() const
+	{
+		for (const Quant &q : quant) {
+			if (q.q.size() > 1) return true;
+		}
+		return false;
+	}
+	// All combinations of the quantization values, one value index per argument
+	std::vector<std::vector<int>> combinations() const
+	{
+		std::vector<std::vector<int>> res(1);
+		for (const Quant &q : quant) {
+			std::vector<std::vector<int>> next;
+			for (const std::vector<int> &c : res) {
+				for (int i = 0; i < q.q.size(); ++i) {
+					next.push_back(c);
+					next.back().push_back(i);
+				}
+			}
+			res.swap(next);
+		}
+		return res;
+	}
 };
 
-void convert_quant(const mesh::attr::Attrs &attrs, const std::vector<Args::Quant> &src, std::vector<quant::Quant> &dst)
+// choice selects one of the values of each argument
+void convert_quant(const mesh::attr::Attrs &attrs, const std::vector<Args::Quant> &src, const std::vector<int> &choice, std::vector<quant::Quant> &dst)
 {
 	for (int i = 0; i < src.size(); ++i) {
-		Args::Quant q = src[i];
-		if (q.q < 0) throw std::runtime_error("Invalid quantization bits");
+		const Args::Quant &q = src[i];
+		int bits = q.q[choice[i]];
+		if (bits < 0) throw std::runtime_error("Invalid quantization bits");
 		if (q.l < 0 || q.l >= attrs.size()) throw std::runtime_error("Invalid list index");
 		if (q.o == -1) {
 			for (int o = 0; o < attrs[q.l].fmt().size(); ++o) {
-				if (q.q > attrs[q.l].fmt().bytes(o) * 8) throw std::runtime_error("Invalid quantization bits");
-				dst.push_back(quant::Quant(q.l, o, q.q));
+				if (bits > attrs[q.l].fmt().bytes(o) * 8) throw std::runtime_error("Invalid quantization bits");
+				dst.push_back(quant::Quant(q.l, o, bits));
 			}
 		} else {
 			if (q.o < 0 || q.o >= attrs[q.l].fmt().size()) throw std::runtime_error("Invalid attribute index");
-			if (q.q > attrs[q.l].fmt().bytes(q.o) * 8) throw std::runtime_error("Invalid quantization bits");
-			dst.push_back(quant::Quant(q.l, q.o, q.q));
+			if (bits > attrs[q.l].fmt().bytes(q.o) * 8) throw std::runtime_error("Invalid quantization bits");
+			dst.push_back(quant::Quant(q.l, q.o, bits));
 		}
 	}
 }
 
+#ifdef WITH_HRY
+// Codes a symbol log without building the mesh
+int recode(Args &args, std::istream &is)
+{
+	unified::writer::FileType type = args.fmt == unified::writer::UNKNOWN ? unified::writer::get_mesh_type(args.out) : args.fmt;
+	if (type != unified::writer::HRY) throw std::runtime_error("A symbol log can only be re-coded to HRY");
+	std::cout << "Re-coding symbol log..." << std::endl;
+	std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
+	std::ofstream os(args.out, std::ofstream::binary);
+	hry::writer::recode(is, os, args.wopts.hry);
+	os.flush();
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+	std::cout << "Re-coding took " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms." << std::endl;
+	std::cout << "Total input size: " << is.tellg() << " Bytes" << std::endl;
+	std::cout << "Total output size: " << os.tellp() << " Bytes" << std::endl;
+	return EXIT_SUCCESS;
+}
+
+// Codes one HRY file per combination of quantization values, the file names get the values of the swept arguments
+int sweep(Args &args, mesh::Mesh &mesh, std::chrono::high_resolution_clock::time_point t0, std::size_t inbytes)
+{
+	unified::writer::FileType type = args.fmt == unified::writer::UNKNOWN ? unified::writer::get_mesh_type(args.out) : args.fmt;
+	if (type != unified::writer::HRY) throw std::runtime_error("A quantization sweep can only be written to HRY");
+
+	std::vector<std::vector<int>> combs = args.combinations();
+	std::vector<std::vector<quant::Quant>> settings(combs.size());
+	std::vector<std::string> names;
+	std::size_t dot = args.out.find_last_of('.');
+	for (std::size_t i = 0; i < combs.size(); ++i) {
+		convert_quant(mesh.attrs, args.quant, combs[i], settings[i]);
+		std::string suffix;
+		for (int j = 0; j < args.quant.size(); ++j) {
+			const Args::Quant &q = args.quant[j];
+			if (q.q.size() == 1) continue;
+			suffix += "-l" + std::to_string(q.l) + (q.o == -1 ? "" : "a" + std::to_string(q.o)) + "q" + std::to_string(q.q[combs[i][j]]);
+		}
+		names.push_back(args.out.substr(0, dot) + suffix + args.out.substr(dot));
+	}
+
+	std::cout << "Writing " << names.size() << " outputs..." << std::endl;
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+	std::vector<std::ofstream> files;
+	std::vector<std::ostream*> outs;
+	for (const std::string &name : names) files.emplace_back(name, std::ofstream::binary);
+	for (std::ofstream &f : files) outs.push_back(&f);
+	hry::writer::write_sweep(mesh, settings, args.clearquant, outs, args.wopts.hry);
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+	std::cout << "Writing outputs took " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << " ms." << std::endl;
+	std::cout << "Total compression time: " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t0).count() << " ms" << std::endl;
+	std::cout << "Total input size: " << inbytes << " Bytes" << std::endl;
+	for (std::size_t i = 0; i < names.size(); ++i) {
+		files[i].flush();
+		std::cout << "Output size of " << names[i] << ": " << files[i].tellp() << " Bytes" << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
+#endif
+
 int main(int argc, const char **argv)
 {
 	Args args(argc, argv);
 
+#ifdef WITH_HRY
+	std::ifstream log(args.in, std::ifstream::binary);
+	if (hry::reader::is_log(log)) return recode(args, log);
+	log.close();
+#endif
+
 	mesh::Mesh mesh;
 	std::cout << "Reading input..." << std::endl;
 	std::chrono::high_resolution_clock::time_point t0 = std::chrono::high_resolution_clock::now();
-	std::size_t inbytes = unified::reader::read(args.in, mesh);
+	std::size_t inbytes = unified::reader::read(args.in, mesh, args.ropts);
 	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
 	std::cout << "Reading input took " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms." << std::endl;
 
+#ifdef WITH_HRY
+	if (args.sweep()) return sweep(args, mesh, t0, inbytes);
+#endif
+
 	if (!args.quant.empty() || args.clearquant) {
 		std::cout << "Quantization..." << std::endl;
 		std::vector<quant::Quant> quant;
-		convert_quant(mesh.attrs, args.quant, quant);
+		convert_quant(mesh.attrs, args.quant, std::vector<int>(args.quant.size(), 0), quant);
 		quant::requant(mesh.attrs, quant, args.clearquant);
 	}
 	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
 	if (!args.quant.empty() || args.clearquant) std::cout << "Quantization took " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << " ms." << std::endl;
 
 	std::cout << "Writing output..." << std::endl;
-	std::size_t outbytes = unified::writer::write(args.out, mesh, args.fmt, args.ply_ascii);
+	std::size_t outbytes = unified::writer::write(args.out, mesh, args.fmt, args.wopts);
 
 	std::chrono::high_resolution_clock::time_point t3 = std::chrono::high_resolution_clock::now();
 	std::cout << "Writing output took " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2).count() << " ms." << std::endl;
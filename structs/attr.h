@@ -10,6 +10,7 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include <iostream>
 
 #include "types.h"
@@ -22,18 +23,13 @@ namespace attr {
 enum Target { FACE, VTX, CORNER, NONE };
 
 struct Attr : mixing::Array {
-	mixing::Array maccu;
-	mixing::Array mcache;
-	mixing::Array mbig;
 	mixing::Array mbounds;
 	Target target;
 	mixing::Interps minterps;
 	mixing::Fmt tmp_fmt;
 
-	Attr(const mixing::Fmt &fmt, const mixing::Interps &_interps, Target &_target) : mixing::Array(fmt), maccu(fmt), mcache(fmt), mbig(fmt.big()), mbounds(fmt.dequantized()), minterps(_interps), target(_target)
+	Attr(const mixing::Fmt &fmt, const mixing::Interps &_interps, Target &_target) : mixing::Array(fmt), mbounds(fmt.dequantized()), minterps(_interps), target(_target)
 	{
-		big().resize(1);
-		accu().resize(2);
 		bounds().resize(4);
 	}
 
@@ -44,9 +40,6 @@ struct Attr : mixing::Array {
 	void restore_fmt()
 	{
 		this->set_fmt(tmp_fmt);
-		maccu.set_fmt(tmp_fmt);
-		mcache.set_fmt(tmp_fmt);
-		mbig.set_fmt(tmp_fmt.big());
 	}
 	mixing::Fmt &tmp()
 	{
@@ -58,18 +51,6 @@ struct Attr : mixing::Array {
 		return minterps;
 	}
 
-	mixing::Array &accu()
-	{
-		return maccu;
-	}
-	mixing::Array &cache()
-	{
-		return mcache;
-	}
-	mixing::Array &big()
-	{
-		return mbig;
-	}
 	mixing::Array &bounds()
 	{
 		return mbounds;
@@ -178,6 +159,14 @@ struct Bindings {
 		return faces.size_edge();
 	}
 
+	// whether any region binds the list
+	bool bound(listidx_t l) const
+	{
+		return std::find(bindings_reg_facelist.begin(), bindings_reg_facelist.end(), l) != bindings_reg_facelist.end() ||
+			std::find(bindings_reg_vtxlist.begin(), bindings_reg_vtxlist.end(), l) != bindings_reg_vtxlist.end() ||
+			std::find(bindings_reg_cornerlist.begin(), bindings_reg_cornerlist.end(), l) != bindings_reg_cornerlist.end();
+	}
+
 	regidx_t face2reg(faceidx_t f) const
 	{
 		return face_regs[f];
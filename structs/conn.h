@@ -231,6 +231,32 @@ struct Builder {
 		++cur_c;
 		last_vtx = vtx;
 	}
+
+	// Bulk construction with the same result as face_begin, set_org and face_end for each face:
+	// add_faces appends faces with the given numbers of edges, init_org sets their origins and may be
+	// called concurrently for distinct corners, merge_faces then connects the faces from first on in face order
+	inline faceidx_t add_faces(const std::vector<ledgeidx_t> &ne)
+	{
+		faceidx_t first = c.num_face();
+		for (ledgeidx_t n : ne) c.add_face(n);
+		return first;
+	}
+	inline void init_org(faceidx_t fi, ledgeidx_t v, vtxidx_t o)
+	{
+		c.edges[c.f.off(fi) + v].org = o;
+	}
+	inline void merge_faces(faceidx_t first)
+	{
+		for (cur_f = first; cur_f < c.num_face(); ++cur_f) {
+			ledgeidx_t ne = c.num_edges(cur_f);
+			for (int e = 1; e <= ne; ++e) {
+				cur_c = e;
+				vtxidx_t a = c.org(cur_f, e - 1), b = c.org(cur_f, e % ne);
+				c.mnum_vtx = std::max(c.mnum_vtx, a + 1);
+				add_edge(a, b);
+			}
+		}
+	}
 };
 
 }
@@ -149,6 +149,24 @@ struct Builder {
 		return mesh.attrs[l][attr].data(eidx);
 	}
 
+	// Removes the list from all regions and frees its attributes; the following bindings of each region move up one slot
+	void unbind_list(listidx_t l)
+	{
+		attr::Attrs &attrs = mesh.attrs;
+		unbind(l, attrs.bindings_reg_vtxlist, attrs.off_reg_vtxlist, attrs.bindings_vtx_attr, attrs.num_bindings_vtx, [&] (auto f) {
+			for (vtxidx_t v = 0; v < attrs.num_vtx(); ++v) f(v, attrs.vtx2reg(v));
+		});
+		unbind(l, attrs.bindings_reg_facelist, attrs.off_reg_facelist, attrs.bindings_face_attr, attrs.num_bindings_face, [&] (auto f) {
+			for (faceidx_t i = 0; i < attrs.num_face(); ++i) f(i, attrs.face2reg(i));
+		});
+		unbind(l, attrs.bindings_reg_cornerlist, attrs.off_reg_cornerlist, attrs.bindings_corner_attr, attrs.num_bindings_corner, [&] (auto f) {
+			for (faceidx_t i = 0; i < mesh.conn.num_face(); ++i) { // only faces, which are already added, have corners
+				for (ledgeidx_t c = 0; c < mesh.faces.num_edges(i); ++c) f(mesh.faces.off(i) + c, attrs.face2reg(i));
+			}
+		});
+		attrs[l].clear();
+	}
+
 	// Connectivity
 	faceidx_t face_begin(ledgeidx_t ne)
 	{
@@ -162,10 +180,55 @@ struct Builder {
 	{
 		builder_conn.set_org(v);
 	}
+	faceidx_t add_faces(const std::vector<ledgeidx_t> &ne)
+	{
+		return builder_conn.add_faces(ne);
+	}
+	void init_org(faceidx_t f, ledgeidx_t v, vtxidx_t o)
+	{
+		builder_conn.init_org(f, v, o);
+	}
+	void merge_faces(faceidx_t first)
+	{
+		builder_conn.merge_faces(first);
+	}
 	void seen_edge(ledgeidx_t ne)
 	{
 		mesh.faces.seen_edge(ne);
 	}
+
+private:
+	// elems(f) calls f(element, region) for all elements with the given bindings
+	template <typename E>
+	static void unbind(listidx_t l, std::vector<listidx_t> &reglist, std::vector<int> &off, std::vector<attridx_t> &bindings, listidx_t stride, E &&elems)
+	{
+		regidx_t nr = off.size() - 1;
+		std::vector<int> slot(nr, -1);
+		bool found = false;
+		for (regidx_t r = 0; r < nr; ++r) {
+			for (int a = off[r]; a < off[r + 1]; ++a) {
+				if (reglist[a] == l) slot[r] = a - off[r], found = true;
+			}
+		}
+		if (!found) return;
+
+		elems([&] (std::size_t i, regidx_t r) {
+			if (slot[r] == -1) return;
+			attridx_t *b = bindings.data() + i * stride;
+			std::copy(b + slot[r] + 1, b + off[r + 1] - off[r], b + slot[r]);
+		});
+
+		std::vector<listidx_t> nreglist;
+		std::vector<int> noff(1, 0);
+		for (regidx_t r = 0; r < nr; ++r) {
+			for (int a = off[r]; a < off[r + 1]; ++a) {
+				if (reglist[a] != l) nreglist.push_back(reglist[a]);
+			}
+			noff.push_back(nreglist.size());
+		}
+		reglist.swap(nreglist);
+		off.swap(noff);
+	}
 };
 
 }
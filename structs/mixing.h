@@ -46,9 +46,10 @@ private:
 	// derived data
 	std::vector<Type> stypes;
 	std::vector<int> offsets;
+	Type ustype; // stype shared by all components or NONE
 
 public:
-	Fmt() : offsets(1, 0)
+	Fmt() : offsets(1, 0), ustype(NONE)
 	{}
 
 	void add(Type t, int q = 0)
@@ -58,6 +59,7 @@ public:
 		Type st = q == 0 ? t : quant_type(q);
 		stypes.push_back(st);
 		offsets.push_back(offsets.back() + SIZES[t]); // std::max(SIZES[t], SIZES[st]) == SIZES[t]
+		ustype = stypes.size() == 1 || ustype == st ? st : NONE;
 	}
 
 	bool isquant(int i) const
@@ -68,6 +70,10 @@ public:
 	{
 		quants[i] = q;
 		stypes[i] = q == 0 ? types[i] : quant_type(q);
+		ustype = stypes[0];
+		for (int j = 1; j < size(); ++j) {
+			if (stypes[j] != ustype) ustype = NONE;
+		}
 	}
 	Type stype(int i) const
 	{
@@ -77,6 +83,10 @@ public:
 	{
 		return types[i];
 	}
+	Type uniform_stype() const
+	{
+		return ustype;
+	}
 	int offset(int i) const
 	{
 		return offsets[i];
@@ -269,9 +279,32 @@ struct View {
 		}
 	}
 
+	// Calls f with a value of the storage type, if all components share it
+	template <typename F>
+	bool uniform(F &&f)
+	{
+		switch (fmt.uniform_stype()) {
+		case FLOAT:  f(float());    return true;
+		case DOUBLE: f(double());   return true;
+		case ULONG:  f(uint64_t()); return true;
+		case LONG:   f(int64_t());  return true;
+		case UINT:   f(uint32_t()); return true;
+		case INT:    f(int32_t());  return true;
+		case USHORT: f(uint16_t()); return true;
+		case SHORT:  f(int16_t());  return true;
+		case UCHAR:  f(uint8_t());  return true;
+		case CHAR:   f(int8_t());   return true;
+		default: return false;
+		}
+	}
+
 	template <typename T, typename ...Args>
 	void set(T &&op, Args ...args)
 	{
+		if (uniform([&] (auto u) {
+			typedef decltype(u) U;
+			for (int i = 0; i < fmt.size(); ++i) at<U>(i) = op.template operator()<U>(args.template at<U>(i)...);
+		})) return;
 		for (int i = 0; i < fmt.size(); ++i) {
 			switch (fmt.stype(i)) {
 			case FLOAT:  at<float>(i)    = op.template operator()<float>   (args.template at<float>   (i)...); break;
@@ -291,6 +324,10 @@ struct View {
 	template <typename T, typename ...Args>
 	void setq(T &&op, Args ...args)
 	{
+		if (uniform([&] (auto u) {
+			typedef decltype(u) U;
+			for (int i = 0; i < fmt.size(); ++i) at<U>(i) = op.template operator()<U>(fmt.quant(i), args.template at<U>(i)...);
+		})) return;
 		for (int i = 0; i < fmt.size(); ++i) {
 			int q = fmt.quant(i);
 			switch (fmt.stype(i)) {
@@ -311,6 +348,10 @@ struct View {
 	template <typename T, typename ...Args>
 	void sets(T &&op, Args ...args)
 	{
+		if (uniform([&] (auto u) {
+			typedef decltype(u) U;
+			for (int i = 0; i < fmt.size(); ++i) at<U>(i) = op.template operator()<U>(args.template get<U>(i)...);
+		})) return;
 		for (int i = 0; i < fmt.size(); ++i) {
 			switch (fmt.stype(i)) {
 			case FLOAT:  at<float>(i)    = op.template operator()<float>   (args.template get<float>   (i)...); break;
@@ -330,6 +371,11 @@ struct View {
 	template <typename T, typename ...Args>
 	void setst(T &&op, Args ...args)
 	{
+		Type ut = fmt.uniform_stype();
+		if (uniform([&] (auto u) {
+			typedef decltype(u) U;
+			for (int i = 0; i < fmt.size(); ++i) at<U>(i) = op.template operator()<U>(ut, args.template get<U>(i)...);
+		})) return;
 		for (int i = 0; i < fmt.size(); ++i) {
 			Type t = fmt.stype(i);
 			switch (t) {
@@ -413,6 +459,12 @@ public:
 		msize = size;
 		mdata.resize(size * mfmt.bytes());
 	}
+	// resize(0), which also releases the memory
+	void clear()
+	{
+		msize = 0;
+		std::vector<unsigned char>().swap(mdata);
+	}
 	std::size_t frontidx()
 	{
 		return 0;
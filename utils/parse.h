@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Number parsing on character ranges without locales and streams. Each function skips leading blanks,
+ * parses one number at p, advances p behind it and returns false if there is no number.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace parse {
+
+inline bool is_blank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+inline const char *skip_blank(const char *p, const char *end)
+{
+	while (p != end && is_blank(*p)) ++p;
+	return p;
+}
+
+// Unsigned integer; a minus sign negates modulo 2^64 like strtoull
+inline bool uint(const char *&p, const char *end, uint64_t &v)
+{
+	const char *s = skip_blank(p, end);
+	bool neg = false;
+	if (s != end && (*s == '-' || *s == '+')) neg = *s++ == '-';
+	if (s == end || *s < '0' || *s > '9') return false;
+	v = 0;
+	for (; s != end && *s >= '0' && *s <= '9'; ++s) v = v * 10 + (*s - '0');
+	if (neg) v = -v;
+	p = s;
+	return true;
+}
+inline bool sint(const char *&p, const char *end, int64_t &v)
+{
+	uint64_t u;
+	if (!uint(p, end, u)) return false;
+	v = (int64_t)u;
+	return true;
+}
+
+// Traits of the binary formats: explicit mantissa bits, exponent bias, largest exponent for Clinger's fast path,
+// range of decimal exponents in which round-to-even ties can occur
+template <typename F> struct binary;
+template <> struct binary<double> {
+	typedef uint64_t bits;
+	static const int MANT = 52, BIAS = 1023, INF = 0x7ff, FAST = 22, EVEN_MIN = -4, EVEN_MAX = 23;
+	static double strto(const char *s, char **e) { return std::strtod(s, e); }
+};
+template <> struct binary<float> {
+	typedef uint32_t bits;
+	static const int MANT = 23, BIAS = 127, INF = 0xff, FAST = 10, EVEN_MIN = -17, EVEN_MAX = 10;
+	static float strto(const char *s, char **e) { return std::strtof(s, e); }
+};
+
+// 128-bit approximations of 5^q for q in [MIN, MAX], normalized to the most significant bit: positive powers are
+// truncated, negative ones are rounded up. Computed once with exact integer arithmetic.
+struct Pow5 {
+	static const int MIN = -342, MAX = 308;
+	uint64_t v[2 * (MAX - MIN + 1)];
+
+	static const Pow5 &get()
+	{
+		static const Pow5 table;
+		return table;
+	}
+	const uint64_t *operator[](int q) const
+	{
+		return v + 2 * (q - MIN);
+	}
+
+private:
+	typedef std::vector<uint32_t> big; // little endian limbs
+
+	static int bits(const big &a)
+	{
+		int n = 32 * (int)a.size();
+		for (uint32_t top = a.back(); !(top & 0x80000000u); top <<= 1) --n;
+		return n;
+	}
+	static void mul(big &a, uint32_t m)
+	{
+		uint64_t c = 0;
+		for (uint32_t &l : a) {
+			c += (uint64_t)l * m;
+			l = (uint32_t)c;
+			c >>= 32;
+		}
+		if (c) a.push_back((uint32_t)c);
+	}
+	static void div(big &a, uint32_t d)
+	{
+		uint64_t r = 0;
+		for (size_t i = a.size(); i-- > 0; ) {
+			r = r << 32 | a[i];
+			a[i] = (uint32_t)(r / d);
+			r %= d;
+		}
+		while (a.size() > 1 && a.back() == 0) a.pop_back();
+	}
+	static void add1(big &a)
+	{
+		for (uint32_t &l : a) if (++l != 0) return;
+		a.push_back(1);
+	}
+	// The 128 bits of a, which start at its most significant bit, or a shifted up to 128 bits
+	void store(int q, const big &a)
+	{
+		int shift = bits(a) - 128;
+		uint64_t *dst = v + 2 * (q - MIN);
+		dst[0] = dst[1] = 0;
+		for (int i = 0; i < 128; ++i) {
+			int b = i + shift;
+			if (b >= 0 && (a[b / 32] >> (b % 32) & 1)) dst[1 - i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+
+	Pow5()
+	{
+		big p5(1, 1);
+		for (int q = 0; q <= MAX; ++q, mul(p5, 5)) store(q, p5);
+		p5.assign(1, 5);
+		for (int q = -1; q >= MIN; --q, mul(p5, 5)) {
+			// floor(2^b / 5^-q) + 1 with b = z + 127 or 2z + 128, where z is the bit length of 5^-q
+			int z = bits(p5), b = q >= -27 ? z + 127 : 2 * z + 128;
+			big a(b / 32 + 1, 0);
+			a.back() = uint32_t(1) << (b % 32);
+			int n = -q;
+			for (; n >= 13; n -= 13) div(a, 1220703125u); // 5^13
+			uint32_t rest = 1;
+			while (n-- > 0) rest *= 5;
+			div(a, rest);
+			add1(a);
+			store(q, a);
+		}
+	}
+};
+
+inline void mul128(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 r = (unsigned __int128)a * b;
+	hi = uint64_t(r >> 64);
+	lo = uint64_t(r);
+#else
+	uint64_t al = (uint32_t)a, ah = a >> 32, bl = (uint32_t)b, bh = b >> 32;
+	uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+	uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+	hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+	lo = mid << 32 | (uint32_t)ll;
+#endif
+}
+
+// Eisel-Lemire: w * 10^q, exactly rounded, for normal results; false for the rare cases, which it cannot decide
+template <typename F>
+bool eisel_lemire(uint64_t w, int q, bool neg, F &v)
+{
+	typedef binary<F> B;
+	if (q < Pow5::MIN || q > Pow5::MAX) return false;
+#ifdef __GNUC__
+	int lz = __builtin_clzll(w);
+#else
+	int lz = 0;
+	while (!(w >> (63 - lz) & 1)) ++lz;
+#endif
+	w <<= lz;
+
+	const uint64_t *p5 = Pow5::get()[q];
+	uint64_t hi, lo;
+	mul128(w, p5[0], hi, lo);
+	const uint64_t mask = ~uint64_t(0) >> (B::MANT + 3);
+	if ((hi & mask) == mask) {
+		// the truncated product might be just below a rounding boundary: add the lower half of the power
+		uint64_t hi2, lo2;
+		mul128(w, p5[1], hi2, lo2);
+		lo += hi2;
+		if (hi2 > lo) ++hi;
+		if (lo == ~uint64_t(0) && (q < -27 || q > 55)) return false;
+	}
+
+	int upper = int(hi >> 63);
+	int shift = upper + 64 - B::MANT - 3;
+	uint64_t mant = hi >> shift;
+	int exp2 = (((152170 + 65536) * q) >> 16) + 63 + upper - lz + B::BIAS;
+	if (exp2 <= 0) return false; // subnormal
+
+	// a product with a zero lower half is exact: ties round to even
+	if (lo <= 1 && q >= B::EVEN_MIN && q <= B::EVEN_MAX && (mant & 3) == 1 && (mant << shift) == hi) mant &= ~uint64_t(1);
+	mant += mant & 1;
+	mant >>= 1;
+	if (mant >= uint64_t(2) << B::MANT) {
+		mant = uint64_t(1) << B::MANT;
+		++exp2;
+	}
+	if (exp2 >= B::INF) return false; // overflow
+
+	typename B::bits r = typename B::bits(mant & ~(uint64_t(1) << B::MANT)) | typename B::bits(exp2) << B::MANT;
+	if (neg) r |= typename B::bits(1) << (sizeof(F) * 8 - 1);
+	std::memcpy(&v, &r, sizeof(F));
+	return true;
+}
+
+// Number at beg by strtod or strtof, the fallback of real
+template <typename F>
+bool slow(const char *&p, const char *end, F &v, const char *beg)
+{
+	const char *e = beg;
+	while (e != end && !is_blank(*e)) ++e;
+	std::string tok(beg, e);
+	char *stop;
+	v = binary<F>::strto(tok.c_str(), &stop);
+	if (stop == tok.c_str()) return false;
+	p = beg + (stop - tok.c_str());
+	return true;
+}
+
+// Float or double, exactly rounded: decimals with a small mantissa and exponent are converted with one exact
+// multiplication or division (Clinger's fast path), other decimals with up to 19 significant digits by Eisel-Lemire,
+// the rest (inf, nan, hexadecimal, long mantissas, subnormals, overflows) by the C library
+template <typename F>
+bool real(const char *&p, const char *end, F &v)
+{
+	static const F POW10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	typedef binary<F> B;
+
+	const char *s = skip_blank(p, end), *beg = s;
+	bool neg = false;
+	if (s != end && (*s == '-' || *s == '+')) neg = *s++ == '-';
+
+	uint64_t m = 0;
+	int digits = 0, exp = 0;
+	bool any = false;
+	for (; s != end && *s >= '0' && *s <= '9'; ++s, any = true) {
+		if (m == 0 && *s == '0') continue; // leading zeros are not significant
+		if (digits < 19) m = m * 10 + (*s - '0');
+		else ++exp;
+		++digits;
+	}
+	if (s != end && *s == '.') {
+		for (++s; s != end && *s >= '0' && *s <= '9'; ++s, any = true) {
+			if (m == 0 && *s == '0') { --exp; continue; }
+			if (digits < 19) { m = m * 10 + (*s - '0'); --exp; }
+			++digits;
+		}
+	}
+	if (!any) return slow(p, end, v, beg);
+	if (s != end && (*s == 'e' || *s == 'E')) {
+		const char *e = s + 1;
+		bool eneg = false;
+		if (e != end && (*e == '-' || *e == '+')) eneg = *e++ == '-';
+		if (e == end || *e < '0' || *e > '9') return slow(p, end, v, beg);
+		int x = 0;
+		for (; e != end && *e >= '0' && *e <= '9'; ++e) if (x < 100000) x = x * 10 + (*e - '0');
+		exp += eneg ? -x : x;
+		s = e;
+	}
+	if (s != end && !is_blank(*s)) return slow(p, end, v, beg);
+	if (digits > 19) return slow(p, end, v, beg); // the mantissa is truncated
+
+	if (m == 0) {
+		v = neg ? -F(0) : F(0);
+	} else if (m <= uint64_t(2) << B::MANT && exp >= -B::FAST && exp <= B::FAST) {
+		v = (F)m;
+		v = exp < 0 ? v / POW10[-exp] : v * POW10[exp];
+		if (neg) v = -v;
+	} else if (!eisel_lemire(m, exp, neg, v)) {
+		return slow(p, end, v, beg);
+	}
+	p = s;
+	return true;
+}
+
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Fixed-size thread pool for data-parallel loops and a ring buffer for pipelines.
+ */
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <functional>
+
+namespace threads {
+
+// number of threads to use for a requested count, where 0 means all hardware threads
+inline unsigned count(unsigned n = 0)
+{
+	if (n != 0) return n;
+	unsigned hw = std::thread::hardware_concurrency();
+	return hw == 0 ? 1 : hw;
+}
+
+struct Pool {
+	std::vector<std::thread> workers;
+	std::mutex m;
+	std::condition_variable wake, done;
+
+	// current job, indices are handed out through next
+	std::function<void(std::size_t)> job;
+	std::size_t n;
+	std::atomic<std::size_t> next;
+	unsigned generation, running;
+	std::exception_ptr error;
+	bool quit;
+
+	Pool(unsigned num_threads = 0) : n(0), next(0), generation(0), running(0), quit(false)
+	{
+		// the calling thread takes part in every loop
+		for (unsigned i = 1; i < count(num_threads); ++i) {
+			workers.emplace_back([this] { work(); });
+		}
+	}
+	~Pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m);
+			quit = true;
+		}
+		wake.notify_all();
+		for (std::thread &t : workers) t.join();
+	}
+
+	Pool(const Pool&) = delete;
+	Pool &operator=(const Pool&) = delete;
+
+	unsigned size() const
+	{
+		return workers.size() + 1;
+	}
+
+	// Calls f(i) for all i in [0, num) and returns when all calls are finished; the first exception is rethrown
+	template <typename F>
+	void run(std::size_t num, F &&f)
+	{
+		if (num == 0) return;
+		if (workers.empty() || num == 1) {
+			for (std::size_t i = 0; i < num; ++i) f(i);
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(m);
+			job = std::ref(f);
+			n = num;
+			next = 0;
+			error = nullptr;
+			running = workers.size();
+			++generation;
+		}
+		wake.notify_all();
+		steal();
+
+		std::unique_lock<std::mutex> lock(m);
+		done.wait(lock, [this] { return running == 0; });
+		job = nullptr;
+		if (error) std::rethrow_exception(error);
+	}
+
+private:
+	void steal()
+	{
+		for (std::size_t i = next++; i < n; i = next++) {
+			try {
+				job(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(m);
+				if (!error) error = std::current_exception();
+				next = n; // skip the remaining calls
+			}
+		}
+	}
+	void work()
+	{
+		unsigned seen = 0;
+		while (1) {
+			{
+				std::unique_lock<std::mutex> lock(m);
+				wake.wait(lock, [this, seen] { return quit || generation != seen; });
+				if (quit) return;
+				seen = generation;
+			}
+			steal();
+			{
+				std::lock_guard<std::mutex> lock(m);
+				if (--running == 0) done.notify_one();
+			}
+		}
+	}
+};
+
+// Lock-free ring buffer between exactly one producer and one consumer thread, which yield while it is full or empty
+template <typename T>
+struct Ring {
+	std::vector<T> buf;
+	std::size_t mask;
+	// each side caches the position of the other one, so the shared positions are only read when the cache is exhausted
+	alignas(64) std::atomic<std::size_t> head; // written by the consumer
+	std::size_t tail_cache;
+	alignas(64) std::atomic<std::size_t> tail; // written by the producer
+	std::size_t head_cache;
+
+	// capacity must be a power of two
+	Ring(std::size_t capacity) : buf(capacity), mask(capacity - 1), head(0), tail_cache(0), tail(0), head_cache(0)
+	{}
+
+	Ring(const Ring&) = delete;
+	Ring &operator=(const Ring&) = delete;
+
+	void push(const T &v)
+	{
+		std::size_t t = tail.load(std::memory_order_relaxed);
+		while (t - head_cache == buf.size()) {
+			head_cache = head.load(std::memory_order_acquire);
+			if (t - head_cache == buf.size()) std::this_thread::yield();
+		}
+		buf[t & mask] = v;
+		tail.store(t + 1, std::memory_order_release);
+	}
+	T pop()
+	{
+		std::size_t h = head.load(std::memory_order_relaxed);
+		while (h == tail_cache) {
+			tail_cache = tail.load(std::memory_order_acquire);
+			if (h == tail_cache) std::this_thread::yield();
+		}
+		T v = buf[h & mask];
+		head.store(h + 1, std::memory_order_release);
+		return v;
+	}
+};
+
+}